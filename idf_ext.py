@@ -6,7 +6,9 @@ idf.py extensions for hotreload component.
 
 Provides commands:
   - idf.py reload: Build and send reloadable ELF to device over HTTP
+  - idf.py reload-daemon: Keep a warm build/upload process for idf.py reload
   - idf.py watch: Watch source files and auto-reload on changes
+  - idf.py invoke: Call an exported module function on the device and time it
 
 The watch command can be combined with monitor or qemu commands:
   - idf.py watch --url <url> monitor
@@ -17,14 +19,20 @@ import atexit
 import fnmatch
 import hashlib
 import hmac as hmac_module
+import http.client
+import json
 import os
+import secrets
+import socket
+import socketserver
 import subprocess
 import sys
 import threading
 import time
 from pathlib import Path
-from typing import Any, Dict, List, Optional, Set
-from urllib.request import urlopen, Request
+from typing import Any, Callable, Dict, List, Optional, Set, Tuple
+from urllib.parse import urlsplit
+from urllib.request import urlopen
 from urllib.error import URLError
 
 import click
@@ -54,13 +62,13 @@ class WatchOptions:
         debounce: float,
         poll_interval: float,
         verbose: bool,
-        hmac_key: Optional[bytes] = None,
     ) -> None:
         """Start the file watcher in a background thread."""
         self._stop_event = threading.Event()
 
         def watcher_loop() -> None:
             watcher = FileWatcher(source_dirs, extensions, debounce)
+            session = ReloadSession(project, build_dir)
             reload_count = 0
 
             while not self._stop_event.is_set():
@@ -78,22 +86,11 @@ class WatchOptions:
 
                     # Build
                     yellow_print("[hotreload] Building...")
-                    result = subprocess.run(
-                        ["idf.py", "-B", str(build_dir), "build"],
-                        cwd=project,
-                        capture_output=True,
-                    )
+                    result = session.build()
 
                     if result.returncode != 0:
                         yellow_print("[hotreload] Build FAILED!")
-                        if verbose:
-                            yellow_print(result.stdout.decode() if result.stdout else "")
-                            yellow_print(result.stderr.decode() if result.stderr else "")
-                        else:
-                            stderr = result.stderr.decode() if result.stderr else ""
-                            for line in stderr.split("\n"):
-                                if "error:" in line.lower():
-                                    yellow_print(f"  {line.strip()}")
+                        _print_build_errors(result, verbose, lambda line: yellow_print(line))
                         continue
 
                     yellow_print("[hotreload] Build successful.")
@@ -105,7 +102,7 @@ class WatchOptions:
                         continue
 
                     yellow_print(f"[hotreload] Uploading {elf_path.name}...")
-                    if _upload_elf(url, elf_path, verbose, hmac_key=hmac_key):
+                    if session.upload(url, elf_path, verbose):
                         yellow_print("[hotreload] Upload complete (app will reload at next safe point)")
                     else:
                         yellow_print("[hotreload] Upload FAILED!")
@@ -126,18 +123,23 @@ class WatchOptions:
             self._watcher_thread.join(timeout=2.0)
 
 
-def _get_main_app_hash(build_dir: Path) -> Optional[str]:
+def _get_main_app_hash(build_dir: Path, app_bin_name: Optional[str] = None) -> Optional[str]:
     """Calculate SHA256 hash of the main application binary."""
-    # Find the main app binary (*.bin in build directory)
-    bin_files = list(build_dir.glob("*.bin"))
-    # Filter out bootloader and partition table
-    app_bins = [f for f in bin_files if not f.name.startswith(("bootloader", "partition"))]
-
-    if not app_bins:
-        return None
-
-    # Use the first matching binary
-    app_bin = app_bins[0]
+    if app_bin_name:
+        app_bin = build_dir / app_bin_name
+        if not app_bin.exists():
+            return None
+    else:
+        # Find the main app binary (*.bin in build directory)
+        bin_files = list(build_dir.glob("*.bin"))
+        # Filter out bootloader and partition table
+        app_bins = [f for f in bin_files if not f.name.startswith(("bootloader", "partition"))]
+
+        if not app_bins:
+            return None
+
+        # Use the first matching binary
+        app_bin = app_bins[0]
 
     sha256 = hashlib.sha256()
     with open(app_bin, "rb") as f:
@@ -154,17 +156,56 @@ def _find_reloadable_elf(build_dir: Path) -> Optional[Path]:
     return None
 
 
-def _load_hmac_key(build_dir: Path) -> Optional[bytes]:
-    """Load the HMAC key from the build directory."""
-    key_path = build_dir / "hotreload_hmac_key.bin"
-    if key_path.exists():
-        return key_path.read_bytes()
-    return None
+class DeviceConnection:
+    """HTTP/1.1 keep-alive connection to the device, reopened when dropped."""
+
+    def __init__(self, url: str, timeout: float = 30.0) -> None:
+        parts = urlsplit(url)
+        self.url = url
+        self._https = parts.scheme == "https"
+        self._host = parts.hostname or "localhost"
+        self._port = parts.port
+        self._timeout = timeout
+        self._conn: Optional[http.client.HTTPConnection] = None
+
+    def request(self, method: str, path: str, body: Optional[bytes] = None,
+                headers: Optional[Dict[str, str]] = None) -> Tuple[int, bytes]:
+        """Send a request and return (status, body).
+
+        A connection the device has closed since the last request is only
+        detected when it is used, so a failed request is retried once on a
+        fresh connection. Uploads are idempotent, so this is safe.
+        """
+        for attempt in range(2):
+            if self._conn is None:
+                conn_class = http.client.HTTPSConnection if self._https else http.client.HTTPConnection
+                self._conn = conn_class(self._host, self._port, timeout=self._timeout)
+            try:
+                self._conn.request(method, path, body=body, headers=headers or {})
+                response = self._conn.getresponse()
+                data = response.read()
+                if response.will_close:
+                    self.close()
+                return response.status, data
+            except (http.client.HTTPException, OSError):
+                self.close()
+                if attempt == 1:
+                    raise
+        raise AssertionError("unreachable")
+
+    def close(self) -> None:
+        if self._conn is not None:
+            self._conn.close()
+            self._conn = None
 
 
 def _upload_elf(url: str, elf_path: Path, verbose: bool = False,
-                hmac_key: Optional[bytes] = None) -> bool:
-    """Upload ELF to device with HMAC authentication."""
+                hmac_key: Optional[bytes] = None,
+                connection: Optional[DeviceConnection] = None) -> bool:
+    """Upload ELF to device with HMAC authentication.
+
+    Uses the given keep-alive connection, or a one-off connection if none.
+    """
     endpoint = f"{url.rstrip('/')}/upload"
 
     if verbose:
@@ -190,19 +231,277 @@ def _upload_elf(url: str, elf_path: Path, verbose: bool = False,
             print(f"  SHA-256: {sha256_hex[:16]}...")
             print(f"  HMAC:    {hmac_hex[:16]}...")
 
+    conn = connection if connection is not None else DeviceConnection(url)
     try:
-        req = Request(endpoint, data=elf_data, headers=headers, method="POST")
-        with urlopen(req, timeout=30) as response:
-            result = response.read().decode()
-            if verbose:
-                print(f"Response: {result}")
-            return response.status == 200
-    except URLError as e:
+        path = urlsplit(endpoint).path
+        status, body = conn.request("POST", path, body=elf_data, headers=headers)
+        if verbose:
+            print(f"Response: {body.decode(errors='replace')}")
+        return status == 200
+    except (http.client.HTTPException, OSError) as e:
         print(f"Error connecting to device: {e}")
         return False
     except Exception as e:
         print(f"Upload failed: {e}")
         return False
+    finally:
+        if connection is None:
+            conn.close()
+
+
+def _print_build_errors(result: subprocess.CompletedProcess, verbose: bool,
+                        log: Callable[[str], None]) -> None:
+    """Print the output of a failed build, or just its error lines."""
+    stdout = result.stdout.decode(errors="replace") if result.stdout else ""
+    stderr = result.stderr.decode(errors="replace") if result.stderr else ""
+    if verbose:
+        log(stdout)
+        log(stderr)
+        return
+    # Ninja reports compiler errors on stdout, idf.py on stderr
+    for line in (stdout + "\n" + stderr).split("\n"):
+        if "error:" in line.lower():
+            log(f"  {line.strip()}")
+
+
+def _read_cmake_cache_value(build_dir: Path, name: str) -> Optional[str]:
+    """Return the value of a CMakeCache.txt entry, or None."""
+    try:
+        with open(build_dir / "CMakeCache.txt") as f:
+            for line in f:
+                key, sep, value = line.rstrip("\n").partition("=")
+                if sep and key.split(":")[0] == name:
+                    return value
+    except OSError:
+        pass
+    return None
+
+
+class ReloadSession:
+    """Build and upload state kept between reloads.
+
+    Holds what every reload would otherwise set up again: the parsed project
+    description, the HMAC key, the build tool and a keep-alive connection to
+    the device. Builds run the generator (ninja) directly in the configured
+    build directory; it re-runs CMake by itself when a CMakeLists.txt changes.
+    Only a build directory that was never configured falls back to idf.py.
+    """
+
+    def __init__(self, project: Path, build_dir: Path) -> None:
+        self.project = project
+        self.build_dir = build_dir
+        self._files: Dict[Path, Tuple[float, Any]] = {}
+        self._connections: Dict[str, DeviceConnection] = {}
+        self._lock = threading.Lock()
+
+    def _cached(self, path: Path, parse: Callable[[Path], Any]) -> Any:
+        """Parse a build directory file, again only after it has changed."""
+        try:
+            mtime = path.stat().st_mtime
+        except OSError:
+            self._files.pop(path, None)
+            return None
+        cached = self._files.get(path)
+        if cached is None or cached[0] != mtime:
+            cached = (mtime, parse(path))
+            self._files[path] = cached
+        return cached[1]
+
+    @property
+    def project_description(self) -> Dict[str, Any]:
+        desc = self._cached(self.build_dir / "project_description.json",
+                            lambda p: json.loads(p.read_text()))
+        return desc or {}
+
+    @property
+    def hmac_key(self) -> Optional[bytes]:
+        return self._cached(self.build_dir / "hotreload_hmac_key.bin", lambda p: p.read_bytes())
+
+    def _build_command(self) -> List[str]:
+        generator = _read_cmake_cache_value(self.build_dir, "CMAKE_GENERATOR")
+        make_program = _read_cmake_cache_value(self.build_dir, "CMAKE_MAKE_PROGRAM")
+        if generator == "Ninja" and make_program and (self.build_dir / "build.ninja").exists():
+            return [make_program, "-C", str(self.build_dir), "all"]
+        return ["idf.py", "-B", str(self.build_dir), "build"]
+
+    def build(self) -> subprocess.CompletedProcess:
+        """Run an incremental build; output is captured."""
+        return subprocess.run(self._build_command(), cwd=self.project, capture_output=True)
+
+    def app_hash(self) -> Optional[str]:
+        return _get_main_app_hash(self.build_dir, self.project_description.get("app_bin"))
+
+    def connection(self, url: str) -> DeviceConnection:
+        conn = self._connections.get(url)
+        if conn is None:
+            conn = DeviceConnection(url)
+            self._connections[url] = conn
+        return conn
+
+    def upload(self, url: str, elf_path: Path, verbose: bool = False) -> bool:
+        return _upload_elf(url, elf_path, verbose, hmac_key=self.hmac_key,
+                           connection=self.connection(url))
+
+    def reload(self, url: str, skip_build: bool, force: bool, verbose: bool,
+               log: Callable[[str], None]) -> Dict[str, Any]:
+        """Build and upload for a reload request; returns the outcome."""
+        with self._lock:
+            pre_build_hash = self.app_hash()
+
+            if not skip_build:
+                log("Building project...")
+                result = self.build()
+                if result.returncode != 0:
+                    log("Build failed!")
+                    _print_build_errors(result, verbose, log)
+                    return {"result": "build_failed"}
+                log("Build successful.")
+
+            post_build_hash = self.app_hash()
+            if not force and pre_build_hash and post_build_hash and pre_build_hash != post_build_hash:
+                return {"result": "app_changed"}
+
+            elf_path = _find_reloadable_elf(self.build_dir)
+            if not elf_path:
+                return {"result": "no_elf"}
+
+            log(f"Uploading {elf_path.name} to {url}...")
+            if not self.upload(url, elf_path, verbose):
+                return {"result": "upload_failed"}
+            return {"result": "ok", "elf": elf_path.name}
+
+
+DAEMON_INFO_FILE = "hotreload_daemon.json"
+
+
+class _DaemonRequestHandler(socketserver.StreamRequestHandler):
+    """One JSON request line in, JSON log lines and a final result line out."""
+
+    def handle(self) -> None:
+        server: "_DaemonServer" = self.server  # type: ignore[assignment]
+
+        def send(message: Dict[str, Any]) -> None:
+            self.wfile.write((json.dumps(message) + "\n").encode())
+            self.wfile.flush()
+
+        try:
+            request = json.loads(self.rfile.readline())
+        except ValueError:
+            return
+        if not hmac_module.compare_digest(str(request.get("token", "")), server.token):
+            send({"result": "denied"})
+            return
+
+        try:
+            outcome = server.session.reload(
+                url=request.get("url") or server.url,
+                skip_build=bool(request.get("skip_build")),
+                force=bool(request.get("force")),
+                verbose=bool(request.get("verbose")),
+                log=lambda line: send({"log": line}),
+            )
+            send(outcome)
+        except OSError:
+            pass  # Client went away
+
+
+class _DaemonServer(socketserver.TCPServer):
+    # Requests are served one at a time: builds must not overlap
+    allow_reuse_address = True
+
+    def __init__(self, session: ReloadSession, url: str, token: str) -> None:
+        super().__init__(("127.0.0.1", 0), _DaemonRequestHandler)
+        self.session = session
+        self.url = url
+        self.token = token
+
+
+def _read_daemon_info(build_dir: Path) -> Optional[Dict[str, Any]]:
+    try:
+        return json.loads((build_dir / DAEMON_INFO_FILE).read_text())
+    except (OSError, ValueError):
+        return None
+
+
+def _daemon_request(info: Dict[str, Any], request: Dict[str, Any]) -> Optional[Dict[str, Any]]:
+    """Send a request to a running daemon and print its log.
+
+    Returns the final result, or None if no daemon answered (e.g. the info
+    file was left behind by a daemon that was killed).
+    """
+    request = dict(request, token=info.get("token", ""))
+    try:
+        with socket.create_connection(("127.0.0.1", int(info["port"])), timeout=2) as sock:
+            sock.settimeout(None)
+            sock.sendall((json.dumps(request) + "\n").encode())
+            for line in sock.makefile("r"):
+                message = json.loads(line)
+                if "log" in message:
+                    print(message["log"])
+                else:
+                    return message
+    except (OSError, ValueError, KeyError):
+        return None
+    return None
+
+
+def _get_benchmark_result(url: str) -> Optional[Dict[str, Any]]:
+    """Fetch the result of the last benchmark comparison from the device."""
+    endpoint = f"{url.rstrip('/')}/benchmark"
+    try:
+        with urlopen(endpoint, timeout=5) as response:
+            return json.loads(response.read().decode())
+    except (URLError, ValueError, OSError):
+        return None
+
+
+def _wait_for_benchmark(url: str, prev_seq: int, timeout: float) -> Optional[Dict[str, Any]]:
+    """Poll the device until a new benchmark comparison is reported."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        result = _get_benchmark_result(url)
+        if result is not None and result.get("seq", 0) != prev_seq:
+            return result
+        time.sleep(0.5)
+    return None
+
+
+def _print_benchmark_result(result: Dict[str, Any]) -> None:
+    """Print a benchmark comparison reported by the device."""
+    verdict = result.get("verdict")
+    old_cycles = result.get("old_cycles", 0)
+    new_cycles = result.get("new_cycles", 0)
+    if verdict == "skipped":
+        print("Benchmark skipped (old or new image has no hotreload_benchmark())")
+        return
+    change = (new_cycles - old_cycles) * 100.0 / old_cycles if old_cycles else 0.0
+    print(f"Benchmark: {old_cycles} -> {new_cycles} cycles ({change:+.1f}%, "
+          f"threshold {result.get('threshold_pct', 0):+d}%)")
+    if verdict == "kept":
+        print("New code kept.")
+    else:
+        print("New code was slower than allowed and has been rolled back on the device.")
+
+
+def _invoke_function(url: str, function: str, call_args: Optional[str], repeat: int,
+                     hmac_key: Optional[bytes]) -> Tuple[int, bytes]:
+    """Send POST /invoke for an exported function, by name or symbol table index."""
+    key = "index" if function.isdigit() else "name"
+    body = f"{key}={function}&repeat={repeat}"
+    if call_args:
+        body += f"&args={call_args}"
+    data = body.encode()
+
+    headers = {"Content-Type": "application/x-www-form-urlencoded"}
+    if hmac_key is not None:
+        headers["X-Hotreload-SHA256"] = hashlib.sha256(data).hexdigest()
+        headers["X-Hotreload-HMAC"] = hmac_module.new(hmac_key, data, hashlib.sha256).hexdigest()
+
+    conn = DeviceConnection(url)
+    try:
+        return conn.request("POST", "/invoke", body=data, headers=headers)
+    finally:
+        conn.close()
 
 
 def _find_reloadable_sources(project: Path, build_dir: Path) -> List[Path]:
@@ -355,11 +654,18 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
         url = action_args.get("url")
         skip_build = action_args.get("skip_build", False)
         verbose = action_args.get("verbose", False)
+        benchmark = action_args.get("benchmark", False)
+        benchmark_timeout = action_args.get("benchmark_timeout", 60.0)
+        no_daemon = action_args.get("no_daemon", False)
 
         # Get URL from environment if not specified
         if not url:
             url = os.environ.get("HOTRELOAD_URL")
 
+        daemon_info = None if no_daemon else _read_daemon_info(build_dir)
+        if not url and daemon_info:
+            url = daemon_info.get("url")
+
         if not url:
             print("Error: Device URL not specified.")
             print("Use --url option or set HOTRELOAD_URL environment variable.")
@@ -370,8 +676,80 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
         if not url.startswith("http://") and not url.startswith("https://"):
             url = f"http://{url}"
 
+        # Remember the last benchmark result, to detect the one for this upload
+        prev_seq = 0
+        if benchmark:
+            prev = _get_benchmark_result(url)
+            if prev is None:
+                print("Error: Device does not report benchmark results (GET /benchmark failed).")
+                sys.exit(1)
+            prev_seq = prev.get("seq", 0)
+
+        # Hand the build and upload to a running 'idf.py reload-daemon'
+        outcome = None
+        if daemon_info:
+            request = {"url": url, "skip_build": skip_build, "force": False, "verbose": verbose}
+            outcome = _daemon_request(daemon_info, request)
+            if outcome is None:
+                print("Reload daemon not responding, building here.")
+            elif outcome["result"] == "app_changed":
+                _confirm_app_changed()
+                outcome = _daemon_request(daemon_info, dict(request, skip_build=True, force=True))
+
+        if outcome is not None:
+            result = outcome["result"]
+            if result == "denied":
+                print("Error: Reload daemon rejected the request (stale hotreload_daemon.json?)")
+                sys.exit(1)
+            if result == "build_failed":
+                sys.exit(1)
+            if result == "no_elf":
+                print("Error: No reloadable ELF found in build directory.")
+                print("Make sure you have a component using hotreload_setup().")
+                sys.exit(1)
+            if result != "ok":
+                print("Upload failed!")
+                sys.exit(1)
+        else:
+            _reload_without_daemon(project, build_dir, url, skip_build, verbose)
+
+        print("Upload complete!")
+        print("(App will reload at next safe point via hotreload_update_available())")
+
+        if benchmark:
+            print(f"Waiting for the device to reload and benchmark the new code (up to {benchmark_timeout:.0f}s)...")
+            result = _wait_for_benchmark(url, prev_seq, benchmark_timeout)
+            if result is None:
+                print("Error: No benchmark result reported. Is CONFIG_HOTRELOAD_BENCHMARK_GATE enabled?")
+                sys.exit(1)
+            _print_benchmark_result(result)
+            if result.get("verdict") == "rolled_back":
+                sys.exit(1)
+
+    def _confirm_app_changed() -> None:
+        print("\nWarning: Main application binary has changed!")
+        print("A full reflash is required: idf.py flash")
+        print("\nThe reloadable module may have dependencies on the main app.")
+        print("If you continue, the device may crash or behave unexpectedly.")
+
+        # Ask for confirmation
+        try:
+            response = input("\nContinue anyway? [y/N]: ")
+            if response.lower() != "y":
+                print("Aborted.")
+                sys.exit(0)
+        except EOFError:
+            # Non-interactive mode, abort
+            print("Non-interactive mode, aborting.")
+            sys.exit(1)
+
+    def _reload_without_daemon(project: Path, build_dir: Path, url: str,
+                               skip_build: bool, verbose: bool) -> None:
+        """Build and upload in this process; exits on failure."""
+        session = ReloadSession(project, build_dir)
+
         # Get hash of main app before build
-        pre_build_hash = _get_main_app_hash(build_dir) if build_dir.exists() else None
+        pre_build_hash = session.app_hash() if build_dir.exists() else None
 
         if verbose:
             print(f"Project: {project}")
@@ -399,24 +777,10 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
             print("Build successful.")
 
         # Check if main app changed
-        post_build_hash = _get_main_app_hash(build_dir)
+        post_build_hash = session.app_hash()
 
         if pre_build_hash and post_build_hash and pre_build_hash != post_build_hash:
-            print("\nWarning: Main application binary has changed!")
-            print("A full reflash is required: idf.py flash")
-            print("\nThe reloadable module may have dependencies on the main app.")
-            print("If you continue, the device may crash or behave unexpectedly.")
-
-            # Ask for confirmation
-            try:
-                response = input("\nContinue anyway? [y/N]: ")
-                if response.lower() != "y":
-                    print("Aborted.")
-                    sys.exit(0)
-            except EOFError:
-                # Non-interactive mode, abort
-                print("Non-interactive mode, aborting.")
-                sys.exit(1)
+            _confirm_app_changed()
 
         # Find reloadable ELF
         elf_path = _find_reloadable_elf(build_dir)
@@ -430,21 +794,123 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
             print(f"Reloadable ELF: {elf_path}")
             print(f"Size: {elf_path.stat().st_size} bytes")
 
-        # Load HMAC key
-        hmac_key = _load_hmac_key(build_dir)
-        if verbose and hmac_key:
-            print(f"HMAC key loaded ({len(hmac_key)} bytes)")
+        if verbose and session.hmac_key:
+            print(f"HMAC key loaded ({len(session.hmac_key)} bytes)")
 
         # Upload and reload
         print(f"Uploading {elf_path.name} to {url}...")
 
-        if _upload_elf(url, elf_path, verbose, hmac_key=hmac_key):
-            print("Upload complete!")
-            print("(App will reload at next safe point via hotreload_update_available())")
-        else:
+        if not session.upload(url, elf_path, verbose):
             print("Upload failed!")
             sys.exit(1)
 
+    def reload_daemon_callback(
+        action: str,
+        ctx: click.Context,
+        args: 'PropertyDict',
+        **action_args: Any
+    ) -> None:
+        """Execute reload-daemon command - serve idf.py reload from a warm process."""
+        project = Path(project_path)
+        build_dir = Path(args.build_dir) if args.build_dir else project / "build"
+        url = action_args.get("url") or os.environ.get("HOTRELOAD_URL")
+
+        if not url:
+            print("Error: Device URL not specified.")
+            print("Use --url option or set HOTRELOAD_URL environment variable.")
+            print("Example: idf.py reload-daemon --url http://192.168.1.100:8080")
+            sys.exit(1)
+
+        if not url.startswith("http://") and not url.startswith("https://"):
+            url = f"http://{url}"
+
+        if not (build_dir / "CMakeCache.txt").exists():
+            print("Error: Build directory is not configured, run 'idf.py build' first.")
+            sys.exit(1)
+
+        session = ReloadSession(project, build_dir)
+        # Parse everything once up front so the first reload is as fast as the rest
+        session.project_description
+        session.hmac_key
+        try:
+            session.connection(url).request("GET", "/status")
+        except (http.client.HTTPException, OSError):
+            pass  # Device not up yet, connect on the first upload
+
+        token = secrets.token_hex(16)
+        server = _DaemonServer(session, url, token)
+        info_path = build_dir / DAEMON_INFO_FILE
+        info = {"pid": os.getpid(), "port": server.server_address[1], "token": token, "url": url}
+        fd = os.open(info_path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600)
+        with os.fdopen(fd, "w") as f:
+            json.dump(info, f)
+
+        def remove_info() -> None:
+            # Only if a newer daemon has not replaced it
+            if _read_daemon_info(build_dir) == info:
+                info_path.unlink()
+
+        atexit.register(remove_info)
+
+        yellow_print(f"[hotreload] Reload daemon listening on 127.0.0.1:{info['port']}")
+        yellow_print(f"[hotreload] Device URL: {url}")
+        yellow_print("[hotreload] 'idf.py reload' now builds and uploads through this process.")
+        yellow_print("[hotreload] Press Ctrl+C to stop.\n")
+
+        try:
+            server.serve_forever()
+        except KeyboardInterrupt:
+            print("\n\nReload daemon stopped.")
+        finally:
+            server.server_close()
+
+    def invoke_callback(
+        action: str,
+        ctx: click.Context,
+        args: 'PropertyDict',
+        function: str,
+        **action_args: Any
+    ) -> None:
+        """Execute invoke command - call a module function on the device."""
+        project = Path(project_path)
+        build_dir = Path(args.build_dir) if args.build_dir else project / "build"
+        url = action_args.get("url") or os.environ.get("HOTRELOAD_URL")
+        call_args = action_args.get("args")
+        repeat = action_args.get("repeat", 1)
+        as_json = action_args.get("json", False)
+
+        if not url:
+            print("Error: Device URL not specified.")
+            print("Use --url option or set HOTRELOAD_URL environment variable.")
+            print("Example: idf.py invoke my_function --url http://192.168.1.100:8080")
+            sys.exit(1)
+
+        if not url.startswith("http://") and not url.startswith("https://"):
+            url = f"http://{url}"
+
+        hmac_key = ReloadSession(project, build_dir).hmac_key
+        try:
+            status, body = _invoke_function(url, function, call_args, repeat, hmac_key)
+        except (http.client.HTTPException, OSError) as e:
+            print(f"Error connecting to device: {e}")
+            sys.exit(1)
+
+        text = body.decode(errors="replace").strip()
+        if status != 200:
+            if status == 404 and "URI" in text:
+                text += " (is CONFIG_HOTRELOAD_INVOKE_ENDPOINT enabled?)"
+            print(f"Invoke failed ({status}): {text}")
+            sys.exit(1)
+
+        if as_json:
+            print(text)
+            return
+        result = json.loads(text)
+        value = "void" if result["result"] is None else result["result"]
+        print(f"{result['name']} = {value}")
+        print(f"  {result['calls']} calls: min {result['min_cycles']}, mean {result['mean_cycles']}, "
+              f"max {result['max_cycles']} cycles")
+
     def watch_callback(
         action: str,
         ctx: click.Context,
@@ -488,9 +954,6 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
             yellow_print(f"  {src_dir.relative_to(project)}")
         yellow_print(f"[hotreload] Device URL: {url}")
 
-        # Load HMAC key
-        hmac_key = _load_hmac_key(build_dir)
-
         # Background mode: start watcher in thread and return immediately
         if watch_options.background_mode:
             yellow_print("[hotreload] Running in background mode (combined with monitor/qemu)")
@@ -503,7 +966,6 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
                 debounce=debounce,
                 poll_interval=poll_interval,
                 verbose=verbose,
-                hmac_key=hmac_key,
             )
             return
 
@@ -512,6 +974,7 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
         yellow_print("[hotreload] Press Ctrl+C to stop.\n")
 
         watcher = FileWatcher(source_dirs, extensions, debounce)
+        session = ReloadSession(project, build_dir)
         reload_count = 0
 
         try:
@@ -532,24 +995,11 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
 
                     # Build
                     print("Building...")
-                    result = subprocess.run(
-                        ["idf.py", "-B", str(build_dir), "build"],
-                        cwd=project,
-                        capture_output=True,
-                    )
+                    result = session.build()
 
                     if result.returncode != 0:
                         print("Build FAILED!")
-                        if verbose:
-                            print(result.stdout.decode() if result.stdout else "")
-                            print(result.stderr.decode() if result.stderr else "")
-                        else:
-                            # Show just the error summary
-                            stderr = result.stderr.decode() if result.stderr else ""
-                            # Find error lines
-                            for line in stderr.split("\n"):
-                                if "error:" in line.lower():
-                                    print(f"  {line.strip()}")
+                        _print_build_errors(result, verbose, print)
                         print("\nWaiting for changes...")
                         continue
 
@@ -563,7 +1013,7 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
                         continue
 
                     print(f"Uploading {elf_path.name}...")
-                    if _upload_elf(url, elf_path, verbose, hmac_key=hmac_key):
+                    if session.upload(url, elf_path, verbose):
                         print("Upload complete (app will reload at next safe point)")
                     else:
                         print("Upload FAILED!")
@@ -590,6 +1040,8 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
                     "2. Checks if the main app binary changed\n"
                     "3. Warns if a full reflash is needed\n"
                     "4. Uploads the reloadable ELF via HTTP\n\n"
+                    "If 'idf.py reload-daemon' is running for the build directory, "
+                    "steps 1-4 are done by the daemon.\n\n"
                     "The device must be running the hotreload HTTP server.\n"
                     "The actual reload happens when the app polls\n"
                     "hotreload_update_available() at a safe point."
@@ -610,6 +1062,28 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
                         "is_flag": True,
                         "default": False,
                     },
+                    {
+                        "names": ["--benchmark"],
+                        "help": (
+                            "Wait for the device to reload and report the old vs new "
+                            "benchmark comparison (requires CONFIG_HOTRELOAD_BENCHMARK_GATE). "
+                            "Exits with an error if the new code was rolled back."
+                        ),
+                        "is_flag": True,
+                        "default": False,
+                    },
+                    {
+                        "names": ["--benchmark-timeout"],
+                        "help": "Seconds to wait for the benchmark result (default: 60)",
+                        "type": float,
+                        "default": 60.0,
+                    },
+                    {
+                        "names": ["--no-daemon"],
+                        "help": "Build and upload in this process even if a reload daemon is running",
+                        "is_flag": True,
+                        "default": False,
+                    },
                     {
                         "names": ["--verbose", "-v"],
                         "help": "Show detailed output",
@@ -618,6 +1092,83 @@ def action_extensions(base_actions: Dict, project_path: str) -> Dict:
                     },
                 ],
             },
+            "reload-daemon": {
+                "callback": reload_daemon_callback,
+                "short_help": "Keep a warm build/upload process for idf.py reload",
+                "help": (
+                    "Run a persistent process that builds and uploads the reloadable "
+                    "ELF on behalf of 'idf.py reload'.\n\n"
+                    "The daemon keeps the parsed project description, the HMAC key "
+                    "and a keep-alive HTTP connection to the device, and runs ninja "
+                    "directly instead of 'idf.py build'. 'idf.py reload' finds it "
+                    "through hotreload_daemon.json in the build directory and only "
+                    "sends it a request.\n\n"
+                    "The daemon listens on 127.0.0.1 only; requests must carry the "
+                    "random token from hotreload_daemon.json.\n\n"
+                    "Runs until Ctrl+C."
+                ),
+                "options": [
+                    {
+                        "names": ["--url"],
+                        "help": (
+                            "Device URL (e.g., http://192.168.1.100:8080). "
+                            "Can also be set via HOTRELOAD_URL environment variable."
+                        ),
+                        "type": str,
+                        "default": None,
+                    },
+                ],
+            },
+            "invoke": {
+                "callback": invoke_callback,
+                "short_help": "Call an exported module function on the device and time it",
+                "help": (
+                    "Call a function of the loaded reloadable module through the "
+                    "POST /invoke endpoint of the device (requires "
+                    "CONFIG_HOTRELOAD_INVOKE_ENDPOINT) and print the return value "
+                    "and the min/mean/max CPU cycles per call.\n\n"
+                    "FUNCTION is the function name or its index in the symbol table. "
+                    "Only functions declared in the component's EXPORT_HEADERS, with "
+                    "up to 6 integer or pointer arguments, can be called.\n\n"
+                    "Example, after 'idf.py reload':\n"
+                    "  idf.py invoke my_filter --args 0x3fc90000,256 --repeat 1000"
+                ),
+                "arguments": [
+                    {
+                        "names": ["function"],
+                        "nargs": 1,
+                    },
+                ],
+                "options": [
+                    {
+                        "names": ["--url"],
+                        "help": (
+                            "Device URL (e.g., http://192.168.1.100:8080). "
+                            "Can also be set via HOTRELOAD_URL environment variable."
+                        ),
+                        "type": str,
+                        "default": None,
+                    },
+                    {
+                        "names": ["--args"],
+                        "help": "Comma-separated integer arguments (decimal, 0x hex or negative)",
+                        "type": str,
+                        "default": None,
+                    },
+                    {
+                        "names": ["--repeat"],
+                        "help": "Number of calls to time (default: 1)",
+                        "type": click.IntRange(1, 100000),
+                        "default": 1,
+                    },
+                    {
+                        "names": ["--json"],
+                        "help": "Print the raw JSON reply of the device",
+                        "is_flag": True,
+                        "default": False,
+                    },
+                ],
+            },
             "watch": {
                 "callback": watch_callback,
                 "short_help": "Watch source files and auto-reload on changes",
@@ -15,6 +15,21 @@
 extern "C" {
 #endif
 
+#define ESP_ERR_HOTRELOAD_BASE      0x1f000                         /*!< Starting number of hotreload error codes */
+#define ESP_ERR_HOTRELOAD_SLOWER    (ESP_ERR_HOTRELOAD_BASE + 1)    /*!< New image failed the benchmark gate and was discarded */
+#define ESP_ERR_HOTRELOAD_IN_USE    (ESP_ERR_HOTRELOAD_BASE + 2)    /*!< A task is executing the loaded code */
+
+/**
+ * @brief Name of the optional benchmark entry point of the reloadable module
+ *
+ * If the module exports a function with this name and the signature
+ * void hotreload_benchmark(void), and CONFIG_HOTRELOAD_BENCHMARK_GATE is
+ * enabled, the function is run for the old and the new image before a reload
+ * is committed. It should exercise the code paths whose speed matters and
+ * must not depend on module state set up by an init function.
+ */
+#define HOTRELOAD_BENCHMARK_SYMBOL "hotreload_benchmark"
+
 /**
  * @brief Configuration for hotreload_load()
  */
@@ -81,9 +96,10 @@ esp_err_t hotreload_load(const hotreload_config_t *config);
 /**
  * @brief Unload the currently loaded reloadable ELF
  *
- * Frees the RAM allocated for the loaded ELF. After calling this,
- * the symbol table entries are invalid and calling through stubs
- * will cause a crash.
+ * Frees the RAM allocated for the loaded ELF and clears the symbol
+ * table. After calling this, calling through stubs will cause a crash.
+ * Interrupts installed with hotreload_intr_alloc() are masked until the
+ * next load.
  *
  * @return
  *      - ESP_OK: Success
@@ -171,13 +187,425 @@ esp_err_t hotreload_update_partition(const char *partition_label,
  * 1. Unloads current ELF
  * 2. Loads new ELF from partition
  *
+ * The unloaded image stays in RAM until the new one is allocated. If no
+ * read-only section changed (code, constants and their relocations, see the
+ * build-time digest) and the memory bounds are the same, the new image takes
+ * over that RAM and only its writable sections are loaded again (see
+ * hotreload_stats_t::reused_size). Any code or constant change reloads
+ * everything.
+ * This needs the old image to be unloaded first, so it does not apply when
+ * both stay live during the load (benchmark gate).
+ *
+ * With CONFIG_HOTRELOAD_BENCHMARK_GATE, the current ELF is kept loaded until
+ * the new one has passed the benchmark comparison (see HOTRELOAD_BENCHMARK_SYMBOL).
+ * If the new code is too slow, it is discarded, the old code stays live and
+ * the pending update flag is cleared. The rejected image stays in the
+ * partition and is loaded by the next hotreload_load(), e.g. after a reset.
+ *
  * @param config Configuration for loading
  * @return
  *      - ESP_OK: Success
+ *      - ESP_ERR_HOTRELOAD_SLOWER: New image failed the benchmark gate, old code kept
  *      - Other errors from hotreload_load()
  */
 esp_err_t hotreload_reload(const hotreload_config_t *config);
 
+/**
+ * @brief Phases of loading a reloadable ELF
+ *
+ * Every load runs these phases in order. Only HOTRELOAD_PHASE_COMMIT touches
+ * the live symbol table; all earlier phases work on a staged copy of the
+ * image and can run while the previous code is still in use.
+ */
+typedef enum {
+    HOTRELOAD_PHASE_PARSE = 0,      /**< Map the partition, validate the ELF, compute layout */
+    HOTRELOAD_PHASE_ALLOC,          /**< Allocate RAM for the new image */
+    HOTRELOAD_PHASE_LOAD,           /**< Copy sections from flash to RAM */
+    HOTRELOAD_PHASE_RELOCATE,       /**< Apply relocations */
+    HOTRELOAD_PHASE_SYNC_CACHE,     /**< Make the new code visible to the instruction bus */
+    HOTRELOAD_PHASE_RESOLVE,        /**< Look up exported symbols in the new image */
+    HOTRELOAD_PHASE_BENCHMARK,      /**< Compare old and new code speed (CONFIG_HOTRELOAD_BENCHMARK_GATE) */
+    HOTRELOAD_PHASE_COMMIT,         /**< Publish the symbol table and free the old image */
+    HOTRELOAD_PHASE_MAX,            /**< Number of phases */
+} hotreload_phase_t;
+
+/**
+ * @brief Outcome of hotreload_reload_within()
+ */
+typedef enum {
+    HOTRELOAD_COMMIT_DONE = 0,      /**< New image is live */
+    HOTRELOAD_COMMIT_IN_PROGRESS,   /**< Some phases ran, call again at the next safe point */
+    HOTRELOAD_COMMIT_DEFERRED,      /**< No phase ran, see the reason field */
+} hotreload_commit_status_t;
+
+/**
+ * @brief Why hotreload_reload_within() did not finish the reload
+ */
+typedef enum {
+    HOTRELOAD_DEFER_NONE = 0,       /**< Not deferred */
+    HOTRELOAD_DEFER_NO_HISTORY,     /**< No timing history for the next phase, pause cannot be predicted */
+    HOTRELOAD_DEFER_OVER_BUDGET,    /**< Next phase is predicted to take longer than the slack */
+    HOTRELOAD_DEFER_BUSY,           /**< Previous load is still publishing in the background */
+} hotreload_defer_reason_t;
+
+/**
+ * @brief Result of hotreload_reload_within()
+ */
+typedef struct {
+    hotreload_commit_status_t status;   /**< What happened during this call */
+    hotreload_defer_reason_t reason;    /**< Why the reload stopped early (DEFERRED or IN_PROGRESS) */
+    hotreload_phase_t next_phase;       /**< Phase that runs on the next call (HOTRELOAD_PHASE_MAX when done) */
+    uint32_t predicted_us;              /**< Predicted duration of next_phase, 0 if unknown */
+    uint32_t elapsed_us;                /**< Time spent inside this call */
+} hotreload_commit_result_t;
+
+/**
+ * @brief Reload from partition without exceeding a time budget
+ *
+ * Deadline-aware variant of hotreload_reload() for hard-periodic tasks.
+ * The caller passes the slack it can afford at this safe point. Using the
+ * timing history of previous loads (per phase, scaled by image size), the
+ * library runs as many load phases as are predicted to fit, and keeps the
+ * partially loaded image staged until the next call. The old code stays
+ * live until the final HOTRELOAD_PHASE_COMMIT, which only publishes the
+ * symbol table and frees the previous image.
+ *
+ * While a reload is staged, both the old and the new image occupy RAM.
+ * If the partition is updated again while a reload is staged, the staged
+ * image is discarded and the reload restarts from HOTRELOAD_PHASE_PARSE.
+ *
+ * History is collected by every load, including hotreload_load(). If there
+ * is no history for a phase yet (e.g. the module was never loaded), the
+ * call defers with HOTRELOAD_DEFER_NO_HISTORY; use hotreload_reload() once
+ * at a moment where a longer pause is acceptable.
+ *
+ * Example usage:
+ * @code
+ * if (hotreload_update_available() || hotreload_reload_in_progress()) {
+ *     hotreload_commit_result_t res;
+ *     ESP_ERROR_CHECK(hotreload_reload_within(&config, slack_us, &res));
+ *     if (res.status == HOTRELOAD_COMMIT_DONE) {
+ *         reloadable_init();
+ *     }
+ * }
+ * @endcode
+ *
+ * @param config Configuration for loading
+ * @param budget_us Time the caller can spend in this call, in microseconds
+ * @param[out] result Outcome of this call
+ * @return
+ *      - ESP_OK: Call succeeded, see result->status
+ *      - ESP_ERR_INVALID_ARG: Invalid arguments
+ *      - ESP_ERR_HOTRELOAD_SLOWER: New image failed the benchmark gate and was discarded
+ *      - Other errors from hotreload_load(); the staged image is discarded
+ *        and the previous code stays live
+ */
+esp_err_t hotreload_reload_within(const hotreload_config_t *config, uint32_t budget_us,
+                                  hotreload_commit_result_t *result);
+
+/**
+ * @brief Check if a reload started by hotreload_reload_within() is pending
+ *
+ * @return
+ *      - true: An image is staged, call hotreload_reload_within() again
+ *      - false: No reload in progress
+ */
+bool hotreload_reload_in_progress(void);
+
+/**
+ * @brief Discard a reload staged by hotreload_reload_within()
+ *
+ * Frees the staged image. The currently live code is not affected.
+ *
+ * @return
+ *      - ESP_OK: Staged image discarded
+ *      - ESP_ERR_INVALID_STATE: No reload in progress
+ */
+esp_err_t hotreload_reload_abort(void);
+
+/**
+ * @brief Reload from partition once no task is executing the current code
+ *
+ * Loads the new image next to the current one, then tries to commit it:
+ * all other tasks are stopped for a moment and their stacks are scanned for
+ * return addresses into the current code. The symbol table is switched only
+ * if none is found; otherwise the commit is retried every few milliseconds
+ * until @p timeout_ms has passed.
+ *
+ * Tasks that may be inside reloadable code at reload time (e.g. blocked in
+ * a module function, or calling back into the main program from it) need no
+ * cooperation: calls through the stubs run at full speed, the check is only
+ * made when reloading. Do not call this from reloadable code. Calls made
+ * from interrupt handlers are not checked.
+ *
+ * Both images are in RAM until the commit, as with CONFIG_HOTRELOAD_BENCHMARK_GATE.
+ *
+ * @param config Configuration for loading
+ * @param timeout_ms How long to keep retrying the commit
+ * @return
+ *      - ESP_OK: New image is live
+ *      - ESP_ERR_INVALID_ARG: Invalid arguments
+ *      - ESP_ERR_TIMEOUT: Current code still in use after @p timeout_ms; the new
+ *        image is discarded and the update stays pending
+ *      - ESP_ERR_HOTRELOAD_SLOWER: New image failed the benchmark gate, old code kept
+ *      - Other errors from hotreload_load()
+ */
+esp_err_t hotreload_reload_when_safe(const hotreload_config_t *config, uint32_t timeout_ms);
+
+/**
+ * @brief Wait until every export of the loaded image is published
+ *
+ * With CONFIG_HOTRELOAD_BACKGROUND_PUBLISH, loads and reloads return as soon
+ * as the exports listed in PRIORITY_EXPORTS are published. A background task
+ * then resolves and publishes the other exports. Until it is done, their
+ * entries of hotreload_symbol_table point to pending stubs, which block the
+ * caller until the export is published and then call the new image. They
+ * must not be called from an interrupt before that.
+ *
+ * The next load, reload, unload or partition update waits for the
+ * background task by itself.
+ *
+ * @param timeout_ms Maximum time to wait
+ * @return
+ *      - ESP_OK: All exports are published (always, without
+ *        CONFIG_HOTRELOAD_BACKGROUND_PUBLISH)
+ *      - ESP_ERR_TIMEOUT: Background task still running
+ */
+esp_err_t hotreload_wait_published(uint32_t timeout_ms);
+
+/**
+ * @brief Timing statistics of one load phase
+ */
+typedef struct {
+    uint32_t last_us;               /**< Duration of the most recent run */
+    uint32_t max_us;                /**< Longest run observed */
+    uint32_t runs;                  /**< Number of runs recorded */
+    uint32_t last_cycles;           /**< CPU cycles of the most recent run. Only meaningful if
+                                         the calling task is pinned to a core. Deterministic
+                                         when running in QEMU with -icount, where the counter
+                                         follows virtual time rather than counting instructions. */
+} hotreload_phase_stats_t;
+
+/**
+ * @brief Outcome of the last benchmark comparison
+ */
+typedef enum {
+    HOTRELOAD_BENCHMARK_NONE = 0,       /**< No comparison done yet */
+    HOTRELOAD_BENCHMARK_SKIPPED,        /**< No old image, or an image without benchmark entry point */
+    HOTRELOAD_BENCHMARK_KEPT,           /**< New code within the threshold, committed */
+    HOTRELOAD_BENCHMARK_ROLLED_BACK,    /**< New code too slow, discarded */
+} hotreload_benchmark_verdict_t;
+
+/**
+ * @brief Result of the last benchmark comparison
+ */
+typedef struct {
+    uint32_t seq;                       /**< Incremented on every comparison */
+    hotreload_benchmark_verdict_t verdict; /**< Outcome */
+    uint32_t old_cycles;                /**< Fastest run of the old image, in CPU cycles */
+    uint32_t new_cycles;                /**< Fastest run of the new image, in CPU cycles */
+    int32_t threshold_pct;              /**< Allowed slowdown in percent */
+} hotreload_benchmark_result_t;
+
+/**
+ * @brief Load statistics
+ */
+typedef struct {
+    hotreload_phase_stats_t phase[HOTRELOAD_PHASE_MAX]; /**< Per-phase timings */
+    size_t image_size;              /**< RAM footprint of the last loaded image, in bytes */
+    size_t reused_size;             /**< Bytes of the last loaded image kept from the previous one (hotreload_reload()) */
+    uint32_t load_count;            /**< Number of images committed since boot */
+    hotreload_benchmark_result_t benchmark; /**< Last benchmark comparison */
+    uint32_t background_us;         /**< Duration of the last background publish (CONFIG_HOTRELOAD_BACKGROUND_PUBLISH) */
+} hotreload_stats_t;
+
+/**
+ * @brief Get load statistics
+ *
+ * @param[out] stats Filled with the current statistics
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: stats is NULL
+ */
+esp_err_t hotreload_get_stats(hotreload_stats_t *stats);
+
+/**
+ * @brief Stack usage of one exported function
+ */
+typedef struct {
+    uint32_t max_depth;             /**< Deepest stack use below the caller, in bytes */
+    uint32_t calls;                 /**< Number of calls measured */
+    bool overflowed;                /**< Reached the end of the tracking window; max_depth is a lower bound */
+} hotreload_stack_usage_t;
+
+/**
+ * @brief Get the stack high-water mark of an exported function
+ *
+ * Requires CONFIG_HOTRELOAD_STACK_TRACKING. Calls into the module from tasks
+ * are measured by the stubs; calls from interrupt handlers are not. The
+ * depth is counted from the caller's stack pointer and includes the stub
+ * and any interrupt frames that landed on the task stack during the call.
+ * Small functions report a floor of a few hundred bytes taken by the probes.
+ *
+ * Figures are reset every time a new image is committed.
+ *
+ * Iterate with index = 0, 1, ... until ESP_ERR_NOT_FOUND is returned.
+ *
+ * @param index Index of the function in the generated symbol table
+ * @param[out] name Name of the function (optional, can be NULL)
+ * @param[out] usage Filled with the recorded figures
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: usage is NULL
+ *      - ESP_ERR_NOT_FOUND: index is past the last exported function
+ *      - ESP_ERR_INVALID_STATE: No image committed yet
+ *      - ESP_ERR_NOT_SUPPORTED: Stack tracking is disabled
+ */
+esp_err_t hotreload_get_stack_usage(size_t index, const char **name, hotreload_stack_usage_t *usage);
+
+/**
+ * @brief Maximum number of arguments hotreload_invoke() passes to a function
+ */
+#define HOTRELOAD_INVOKE_MAX_ARGS 6
+
+/**
+ * @brief Kind of value returned by an invoked function
+ */
+typedef enum {
+    HOTRELOAD_INVOKE_RET_VOID = 0,      /**< No return value */
+    HOTRELOAD_INVOKE_RET_INT,           /**< Signed integer of up to 32 bits */
+    HOTRELOAD_INVOKE_RET_UINT,          /**< Unsigned integer of up to 32 bits, or bool */
+    HOTRELOAD_INVOKE_RET_PTR,           /**< Pointer */
+} hotreload_invoke_ret_t;
+
+/**
+ * @brief Result of hotreload_invoke()
+ */
+typedef struct {
+    hotreload_invoke_ret_t ret_type;    /**< Kind of value in result */
+    uint32_t result;                    /**< Value returned by the last call, 0 for void functions */
+    uint32_t calls;                     /**< Number of calls made */
+    uint32_t min_cycles;                /**< Fastest call, in CPU cycles */
+    uint32_t mean_cycles;               /**< Average call, in CPU cycles */
+    uint32_t max_cycles;                /**< Slowest call, in CPU cycles */
+} hotreload_invoke_result_t;
+
+/**
+ * @brief Call an exported function of the loaded module and time it
+ *
+ * The function is called @p repeat times through its address in the symbol
+ * table, without the stub, with the same arguments every time. Each call is
+ * timed with the CPU cycle counter on the calling core.
+ *
+ * Only functions declared in the component's EXPORT_HEADERS can be called:
+ * the build records their signatures, and only functions taking at most
+ * HOTRELOAD_INVOKE_MAX_ARGS integer or pointer arguments (up to 32 bits
+ * each) and returning void, such an integer or a pointer are supported.
+ * Pointer arguments are passed as given and must be valid for the function.
+ *
+ * The image is not replaced or unloaded while the calls run: the commit of
+ * a reload and hotreload_unload() wait until this returns, so keep @p repeat
+ * small enough for the reload latency the application can accept.
+ *
+ * @param index Index of the function in the generated symbol table
+ * @param args Arguments (can be NULL if nargs is 0)
+ * @param nargs Number of arguments, must match the function's signature
+ * @param repeat Number of calls, at least 1
+ * @param[out] result Filled with the return value and cycle counts
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: result is NULL, repeat is 0 or nargs does not match
+ *      - ESP_ERR_NOT_FOUND: index is past the last exported function
+ *      - ESP_ERR_NOT_SUPPORTED: Signature unknown or not supported
+ *      - ESP_ERR_INVALID_STATE: Function not loaded
+ */
+esp_err_t hotreload_invoke(size_t index, const uint32_t *args, size_t nargs, uint32_t repeat,
+                           hotreload_invoke_result_t *result);
+
+/**
+ * @brief Handle of an interrupt handler registered with hotreload_intr_alloc()
+ */
+typedef struct hotreload_intr_s *hotreload_intr_handle_t;
+
+/**
+ * @brief Install a function of the reloadable module as an interrupt handler
+ *
+ * Allocates the interrupt once with esp_intr_alloc(), with the handler's
+ * address in the loaded image; the interrupt path does not go through a
+ * stub. On reload, only this interrupt line is masked while its vector entry
+ * is rewritten with the new address on the core that owns it. The interrupt
+ * keeps its CPU line, core and enabled state. On hotreload_unload() the
+ * interrupt is masked until the next load.
+ *
+ * A load or reload whose image does not export the handler fails with
+ * ESP_ERR_NOT_FOUND in the resolve phase, before anything is published.
+ *
+ * Shared interrupts (ESP_INTR_FLAG_SHARED) are not supported.
+ *
+ * The handler must be an exported function of the module (it must appear in
+ * the generated symbol table) with the intr_handler_t signature.
+ *
+ * With ESP_INTR_FLAG_IRAM, the module must be loaded into internal RAM and
+ * @p arg must point to internal RAM, otherwise esp_intr_alloc() rejects it.
+ *
+ * With ESP_INTR_FLAG_INTRDISABLED, the interrupt starts disabled; use
+ * hotreload_intr_enable() and hotreload_intr_disable() rather than
+ * esp_intr_enable() so that the state survives unloads.
+ *
+ * @param source Interrupt source, see esp_intr_alloc()
+ * @param flags ESP_INTR_FLAG_* flags, see esp_intr_alloc()
+ * @param handler_name Name of the exported handler function
+ * @param arg Argument passed to the handler
+ * @param[out] ret_handle Handle of the registration
+ * @return
+ *      - ESP_OK: Handler installed
+ *      - ESP_ERR_INVALID_ARG: Invalid arguments
+ *      - ESP_ERR_NOT_SUPPORTED: ESP_INTR_FLAG_SHARED is set
+ *      - ESP_ERR_NOT_FOUND: handler_name is not exported by the module
+ *      - ESP_ERR_INVALID_STATE: Module not loaded
+ *      - ESP_ERR_NO_MEM: Out of memory
+ *      - Other errors from esp_intr_alloc()
+ */
+esp_err_t hotreload_intr_alloc(int source, int flags, const char *handler_name,
+                               void *arg, hotreload_intr_handle_t *ret_handle);
+
+/**
+ * @brief Enable an interrupt installed with hotreload_intr_alloc()
+ *
+ * While no image is loaded, the interrupt is enabled by the next load.
+ *
+ * @param handle Handle returned by hotreload_intr_alloc()
+ * @return
+ *      - ESP_OK: Interrupt enabled
+ *      - ESP_ERR_INVALID_ARG: Unknown handle
+ *      - Other errors from esp_intr_enable()
+ */
+esp_err_t hotreload_intr_enable(hotreload_intr_handle_t handle);
+
+/**
+ * @brief Disable an interrupt installed with hotreload_intr_alloc()
+ *
+ * The interrupt stays disabled across reloads until hotreload_intr_enable().
+ *
+ * @param handle Handle returned by hotreload_intr_alloc()
+ * @return
+ *      - ESP_OK: Interrupt disabled
+ *      - ESP_ERR_INVALID_ARG: Unknown handle
+ *      - Other errors from esp_intr_disable()
+ */
+esp_err_t hotreload_intr_disable(hotreload_intr_handle_t handle);
+
+/**
+ * @brief Remove an interrupt handler installed with hotreload_intr_alloc()
+ *
+ * @param handle Handle returned by hotreload_intr_alloc()
+ * @return
+ *      - ESP_OK: Handler removed
+ *      - ESP_ERR_INVALID_ARG: Unknown handle
+ *      - Other errors from esp_intr_free()
+ */
+esp_err_t hotreload_intr_free(hotreload_intr_handle_t handle);
+
 /**
  * @brief Configuration for the hotreload HTTP server
  */
@@ -208,6 +636,8 @@ typedef struct {
  * - POST /reload            - Reload from flash partition
  * - POST /upload-and-reload - Upload and reload in one request
  * - GET  /status            - Check server status
+ * - GET  /benchmark         - Result of the last benchmark comparison
+ * - POST /invoke            - Call an exported function (CONFIG_HOTRELOAD_INVOKE_ENDPOINT)
  *
  * @param config Server configuration
  * @return
@@ -64,8 +64,10 @@ static const char *TAG = "elf_reloc_riscv";
  * @param parser ELF parser handle
  * @param ram_base Base address of loaded ELF
  * @param load_base Adjustment: ram_base - vma_base
+ * @param mem_ctx Memory context, a reused .plt is already patched
  */
-static void patch_plt_for_iram(elf_parser_handle_t parser, void *ram_base, uintptr_t load_base)
+static void patch_plt_for_iram(elf_parser_handle_t parser, void *ram_base, uintptr_t load_base,
+                               const elf_port_mem_ctx_t *mem_ctx)
 {
     ESP_LOGD(TAG, "Looking for .plt section to patch...");
 
@@ -99,6 +101,11 @@ static void patch_plt_for_iram(elf_parser_handle_t parser, void *ram_base, uintp
             return;
         }
 
+        if (elf_port_vma_reused(mem_ctx, plt_vma)) {
+            ESP_LOGD(TAG, ".plt kept from the previous load, already patched");
+            return;
+        }
+
         ESP_LOGD(TAG, "Patching .plt section at vma=0x%" PRIxPTR " size=%" PRIu32, plt_vma, plt_size);
 
         /* Calculate adjustment for AUIPC: subtract SOC_I_D_OFFSET >> 12 from immediate
@@ -163,8 +170,7 @@ esp_err_t elf_port_apply_relocations(elf_parser_handle_t parser,
                                      size_t ram_size,
                                      const elf_port_mem_ctx_t *mem_ctx)
 {
-    (void)ram_base;  /* Used via load_base */
-    (void)mem_ctx;   /* I/D offset is compile-time on RISC-V */
+    (void)ram_base;  /* Used via load_base; I/D offset is compile-time on RISC-V */
 
     /* Reset PCREL_HI20 table for this load */
     s_pcrel_hi20_count = 0;
@@ -193,6 +199,11 @@ esp_err_t elf_port_apply_relocations(elf_parser_handle_t parser,
             continue;
         }
 
+        /* Kept from the previous load with this relocation already applied */
+        if (elf_port_vma_reused(mem_ctx, offset)) {
+            continue;
+        }
+
         /* Calculate location in RAM to patch
          * offset is the VMA where the relocation applies */
         uintptr_t location_addr = load_base + offset;
@@ -407,18 +418,18 @@ esp_err_t elf_port_post_load(elf_parser_handle_t parser,
                              const elf_port_mem_ctx_t *mem_ctx)
 {
     (void)vma_base;
-    (void)mem_ctx;
 
 #ifdef SOC_I_D_OFFSET
     /* On RISC-V with separate IRAM/DRAM address spaces (ESP32-C2, C3),
      * patch PLT entries so their PC-relative GOT access uses DRAM addresses.
      * This must be done before processing relocations since PLT entries
      * will be used when calling external functions. */
-    patch_plt_for_iram(parser, ram_base, load_base);
+    patch_plt_for_iram(parser, ram_base, load_base, mem_ctx);
 #else
     (void)parser;
     (void)ram_base;
     (void)load_base;
+    (void)mem_ctx;
 #endif
 
     return ESP_OK;
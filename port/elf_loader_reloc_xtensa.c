@@ -234,6 +234,11 @@ esp_err_t elf_port_apply_relocations(elf_parser_handle_t parser,
             continue;
         }
 
+        /* Kept from the previous load with this relocation already applied */
+        if (elf_port_vma_reused(mem_ctx, offset)) {
+            continue;
+        }
+
         /* Calculate location in RAM to patch
          * offset is the VMA where the relocation applies */
         uintptr_t location_addr = vma_to_ram(mem_ctx, offset, load_base);
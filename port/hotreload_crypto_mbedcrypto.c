@@ -14,6 +14,7 @@
 #include "mbedtls/sha256.h"
 #include "mbedtls/md.h"
 #include "mbedtls/constant_time.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "hotreload_crypto";
@@ -24,6 +25,11 @@ static const char *TAG = "hotreload_crypto";
 static uint8_t s_hmac_key[HMAC_KEY_MAX_LEN];
 static size_t  s_hmac_key_len = 0;
 
+struct hotreload_crypto_verify_ctx {
+    mbedtls_sha256_context sha;
+    mbedtls_md_context_t hmac;
+};
+
 esp_err_t hotreload_crypto_init(const uint8_t *key, size_t key_len)
 {
     if (key == NULL || key_len == 0) {
@@ -46,49 +52,95 @@ void hotreload_crypto_deinit(void)
     s_hmac_key_len = 0;
 }
 
-esp_err_t hotreload_crypto_sha256_verify(const uint8_t *data, size_t data_len,
-                                         const uint8_t *expected_hash)
+esp_err_t hotreload_crypto_verify_start(hotreload_crypto_verify_ctx_t **out_ctx)
 {
-    uint8_t actual[HOTRELOAD_SHA256_LEN];
+    if (out_ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_hmac_key_len == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    int ret = mbedtls_sha256(data, data_len, actual, 0 /* is224 = false */);
-    if (ret != 0) {
-        ESP_LOGE(TAG, "mbedtls_sha256 failed: -0x%04x", -ret);
+    const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if (md_info == NULL) {
+        ESP_LOGE(TAG, "SHA-256 digest info not available");
         return ESP_FAIL;
     }
 
-    if (mbedtls_ct_memcmp(actual, expected_hash, HOTRELOAD_SHA256_LEN) != 0) {
-        ESP_LOGW(TAG, "SHA-256 mismatch (corrupted upload)");
-        return ESP_ERR_INVALID_STATE;
+    hotreload_crypto_verify_ctx_t *ctx = malloc(sizeof(*ctx));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
     }
+    mbedtls_sha256_init(&ctx->sha);
+    mbedtls_md_init(&ctx->hmac);
 
+    int ret = mbedtls_sha256_starts(&ctx->sha, 0 /* is224 = false */);
+    if (ret == 0) {
+        ret = mbedtls_md_setup(&ctx->hmac, md_info, 1 /* hmac */);
+    }
+    if (ret == 0) {
+        ret = mbedtls_md_hmac_starts(&ctx->hmac, s_hmac_key, s_hmac_key_len);
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to start verification: -0x%04x", -ret);
+        hotreload_crypto_verify_abort(ctx);
+        return ESP_FAIL;
+    }
+
+    *out_ctx = ctx;
     return ESP_OK;
 }
 
-esp_err_t hotreload_crypto_hmac_verify(const uint8_t *data, size_t data_len,
-                                       const uint8_t *expected_hmac)
+esp_err_t hotreload_crypto_verify_update(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *data, size_t data_len)
 {
-    uint8_t actual[HOTRELOAD_HMAC_LEN];
-
-    const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-    if (md_info == NULL) {
-        ESP_LOGE(TAG, "SHA-256 digest info not available");
+    int ret = mbedtls_sha256_update(&ctx->sha, data, data_len);
+    if (ret == 0) {
+        ret = mbedtls_md_hmac_update(&ctx->hmac, data, data_len);
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Failed to update digests: -0x%04x", -ret);
         return ESP_FAIL;
     }
+    return ESP_OK;
+}
+
+esp_err_t hotreload_crypto_verify_finish(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *expected_hash,
+                                         const uint8_t *expected_hmac)
+{
+    uint8_t actual_hash[HOTRELOAD_SHA256_LEN];
+    uint8_t actual_hmac[HOTRELOAD_HMAC_LEN];
 
-    int ret = mbedtls_md_hmac(md_info,
-                               s_hmac_key, s_hmac_key_len,
-                               data, data_len,
-                               actual);
+    int ret = mbedtls_sha256_finish(&ctx->sha, actual_hash);
+    if (ret == 0) {
+        ret = mbedtls_md_hmac_finish(&ctx->hmac, actual_hmac);
+    }
+    hotreload_crypto_verify_abort(ctx);
     if (ret != 0) {
-        ESP_LOGE(TAG, "mbedtls_md_hmac failed: -0x%04x", -ret);
+        ESP_LOGE(TAG, "Failed to finish digests: -0x%04x", -ret);
         return ESP_FAIL;
     }
 
-    if (mbedtls_ct_memcmp(actual, expected_hmac, HOTRELOAD_HMAC_LEN) != 0) {
+    if (mbedtls_ct_memcmp(actual_hash, expected_hash, HOTRELOAD_SHA256_LEN) != 0) {
+        ESP_LOGW(TAG, "SHA-256 mismatch (corrupted upload)");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (mbedtls_ct_memcmp(actual_hmac, expected_hmac, HOTRELOAD_HMAC_LEN) != 0) {
         ESP_LOGW(TAG, "HMAC-SHA256 mismatch (authentication failed)");
         return ESP_FAIL;
     }
 
     return ESP_OK;
 }
+
+void hotreload_crypto_verify_abort(hotreload_crypto_verify_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    mbedtls_sha256_free(&ctx->sha);
+    mbedtls_md_free(&ctx->hmac);
+    free(ctx);
+}
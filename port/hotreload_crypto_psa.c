@@ -9,6 +9,7 @@
  * @brief Crypto backend using PSA Crypto API (mbedTLS 4.x / IDF 6.x)
  */
 
+#include <stdlib.h>
 #include "hotreload_crypto.h"
 #include "esp_log.h"
 #include "psa/crypto.h"
@@ -17,6 +18,11 @@ static const char *TAG = "hotreload_crypto";
 
 static psa_key_id_t s_hmac_key_id = 0;
 
+struct hotreload_crypto_verify_ctx {
+    psa_hash_operation_t hash;
+    psa_mac_operation_t mac;
+};
+
 esp_err_t hotreload_crypto_init(const uint8_t *key, size_t key_len)
 {
     if (key == NULL || key_len == 0) {
@@ -53,37 +59,85 @@ void hotreload_crypto_deinit(void)
     }
 }
 
-esp_err_t hotreload_crypto_sha256_verify(const uint8_t *data, size_t data_len,
-                                         const uint8_t *expected_hash)
+esp_err_t hotreload_crypto_verify_start(hotreload_crypto_verify_ctx_t **out_ctx)
 {
-    psa_status_t status = psa_hash_compare(PSA_ALG_SHA_256,
-                                           data, data_len,
-                                           expected_hash, HOTRELOAD_SHA256_LEN);
-    if (status == PSA_ERROR_INVALID_SIGNATURE) {
-        ESP_LOGW(TAG, "SHA-256 mismatch (corrupted upload)");
+    if (out_ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_hmac_key_id == 0) {
         return ESP_ERR_INVALID_STATE;
     }
+
+    hotreload_crypto_verify_ctx_t *ctx = malloc(sizeof(*ctx));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->hash = psa_hash_operation_init();
+    ctx->mac = psa_mac_operation_init();
+
+    psa_status_t status = psa_hash_setup(&ctx->hash, PSA_ALG_SHA_256);
+    if (status == PSA_SUCCESS) {
+        status = psa_mac_verify_setup(&ctx->mac, s_hmac_key_id, PSA_ALG_HMAC(PSA_ALG_SHA_256));
+    }
     if (status != PSA_SUCCESS) {
-        ESP_LOGE(TAG, "psa_hash_compare failed: %d", (int)status);
+        ESP_LOGE(TAG, "Failed to start verification: %d", (int)status);
+        hotreload_crypto_verify_abort(ctx);
         return ESP_FAIL;
     }
+
+    *out_ctx = ctx;
     return ESP_OK;
 }
 
-esp_err_t hotreload_crypto_hmac_verify(const uint8_t *data, size_t data_len,
-                                       const uint8_t *expected_hmac)
+esp_err_t hotreload_crypto_verify_update(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *data, size_t data_len)
 {
-    psa_status_t status = psa_mac_verify(s_hmac_key_id,
-                                         PSA_ALG_HMAC(PSA_ALG_SHA_256),
-                                         data, data_len,
-                                         expected_hmac, HOTRELOAD_HMAC_LEN);
-    if (status == PSA_ERROR_INVALID_SIGNATURE) {
-        ESP_LOGW(TAG, "HMAC-SHA256 mismatch (authentication failed)");
-        return ESP_FAIL;
+    psa_status_t status = psa_hash_update(&ctx->hash, data, data_len);
+    if (status == PSA_SUCCESS) {
+        status = psa_mac_update(&ctx->mac, data, data_len);
     }
     if (status != PSA_SUCCESS) {
-        ESP_LOGE(TAG, "psa_mac_verify failed: %d", (int)status);
+        ESP_LOGE(TAG, "Failed to update digests: %d", (int)status);
         return ESP_FAIL;
     }
     return ESP_OK;
 }
+
+esp_err_t hotreload_crypto_verify_finish(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *expected_hash,
+                                         const uint8_t *expected_hmac)
+{
+    esp_err_t ret = ESP_OK;
+
+    psa_status_t status = psa_hash_verify(&ctx->hash, expected_hash, HOTRELOAD_SHA256_LEN);
+    if (status == PSA_ERROR_INVALID_SIGNATURE) {
+        ESP_LOGW(TAG, "SHA-256 mismatch (corrupted upload)");
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (status != PSA_SUCCESS) {
+        ESP_LOGE(TAG, "psa_hash_verify failed: %d", (int)status);
+        ret = ESP_FAIL;
+    } else {
+        status = psa_mac_verify_finish(&ctx->mac, expected_hmac, HOTRELOAD_HMAC_LEN);
+        if (status == PSA_ERROR_INVALID_SIGNATURE) {
+            ESP_LOGW(TAG, "HMAC-SHA256 mismatch (authentication failed)");
+            ret = ESP_FAIL;
+        } else if (status != PSA_SUCCESS) {
+            ESP_LOGE(TAG, "psa_mac_verify_finish failed: %d", (int)status);
+            ret = ESP_FAIL;
+        }
+    }
+
+    hotreload_crypto_verify_abort(ctx);
+    return ret;
+}
+
+void hotreload_crypto_verify_abort(hotreload_crypto_verify_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    // No-ops on operations that already finished
+    psa_hash_abort(&ctx->hash);
+    psa_mac_abort(&ctx->mac);
+    free(ctx);
+}
@@ -16,6 +16,9 @@
 extern "C" {
 #endif
 
+/** Length of the read-only digest recorded by gen_readonly_digest.py */
+#define ELF_LOADER_DIGEST_LEN 32
+
 /**
  * @brief ELF loader context structure
  *
@@ -52,6 +55,12 @@ typedef struct {
     elf_port_mem_ctx_t text_mem_ctx; /**< Port layer memory context (text region) */
 
     bool split_alloc;         /**< True when using separate text/data allocations */
+
+    /* Section reuse (see elf_loader_reuse()) */
+    uint8_t ro_digest[ELF_LOADER_DIGEST_LEN]; /**< Digest of all read-only sections and their relocations */
+    elf_port_vma_range_t *ro_ranges; /**< VMA ranges of the read-only sections, NULL without digest */
+    size_t ro_range_count;    /**< Number of entries in ro_ranges */
+    size_t reused_size;       /**< Bytes kept from the previous load */
 } elf_loader_ctx_t;
 
 /**
@@ -123,11 +132,35 @@ esp_err_t elf_loader_calculate_memory_layout(elf_loader_ctx_t *ctx,
  */
 esp_err_t elf_loader_allocate(elf_loader_ctx_t *ctx);
 
+/**
+ * @brief Take over the RAM of a previous load with the same layout
+ *
+ * Alternative to elf_loader_allocate() when the image in @p prev is no longer
+ * in use. If both ELFs have the same memory bounds and the same digest of
+ * their read-only sections (see scripts/gen_readonly_digest.py), @p ctx takes
+ * ownership of the memory of @p prev. The read-only sections are then skipped
+ * by elf_loader_load_sections() and elf_loader_apply_relocations(): they
+ * already hold the relocated contents. Writable sections are loaded again.
+ *
+ * On error @p prev is left untouched. In both cases it must still be
+ * released with elf_loader_cleanup().
+ *
+ * @param ctx Loader context with calculated layout, not allocated
+ * @param prev Loader context of the previous image, allocated and loaded
+ * @return
+ *      - ESP_OK: Memory taken over, ctx->reused_size bytes are kept
+ *      - ESP_ERR_INVALID_ARG: NULL argument
+ *      - ESP_ERR_INVALID_STATE: Layout not calculated, or @p prev not allocated
+ *      - ESP_ERR_NOT_SUPPORTED: No digest, or the read-only sections or bounds differ
+ */
+esp_err_t elf_loader_reuse(elf_loader_ctx_t *ctx, elf_loader_ctx_t *prev);
+
 /**
  * @brief Load sections into RAM
  *
  * Copies PROGBITS sections from flash to RAM.
  * Zero-fills NOBITS sections (.bss).
+ * Read-only sections kept by elf_loader_reuse() are skipped.
  *
  * @param ctx Loader context with allocated RAM
  * @return
@@ -175,6 +208,22 @@ esp_err_t elf_loader_sync_cache(elf_loader_ctx_t *ctx);
  */
 void *elf_loader_get_symbol(elf_loader_ctx_t *ctx, const char *name);
 
+/**
+ * @brief Get the instruction bus address range of the loaded code
+ *
+ * With split allocation this is the text region only; otherwise it is the
+ * whole RAM image. Return addresses into the loaded code fall in this range.
+ *
+ * @param ctx Loader context with allocated RAM
+ * @param[out] lo First address of the range
+ * @param[out] hi One past the last address of the range
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: NULL argument
+ *      - ESP_ERR_INVALID_STATE: RAM not allocated
+ */
+esp_err_t elf_loader_get_exec_range(const elf_loader_ctx_t *ctx, uintptr_t *lo, uintptr_t *hi);
+
 /**
  * @brief Clean up loader context
  *
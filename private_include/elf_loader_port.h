@@ -26,6 +26,14 @@
 extern "C" {
 #endif
 
+/**
+ * @brief VMA range of a section kept in RAM from the previous load
+ */
+typedef struct {
+    uintptr_t lo;   /**< First VMA of the range */
+    uintptr_t hi;   /**< One past the last VMA of the range */
+} elf_port_vma_range_t;
+
 /**
  * @brief Memory context for chips requiring special address translation
  *
@@ -37,6 +45,7 @@ extern "C" {
  * - mmu_off, mmu_num: MMU entry tracking for chips requiring dynamic mapping
  * - text_off: Offset from data address to instruction address (PSRAM or I/D split)
  * - split_* fields: For split text/data allocation (ESP32)
+ * - reused, reused_count: Sections kept by elf_loader_reuse()
  */
 typedef struct {
     int mmu_off;        /**< ESP32-S2: MMU entry offset (first entry index) */
@@ -52,8 +61,31 @@ typedef struct {
     uintptr_t data_load_base;  /**< data_base - data_vma_lo */
     uintptr_t data_vma_lo;     /**< Lowest VMA of data region */
     uintptr_t data_vma_hi;     /**< Highest VMA of data region */
+
+    /* Section reuse - set by the core loader. These ranges still hold the
+     * relocated contents of the previous load, so relocation handlers and
+     * post-load fixups must leave them alone. */
+    const elf_port_vma_range_t *reused;  /**< Reused ranges, NULL if none */
+    size_t reused_count;                 /**< Number of entries in reused */
 } elf_port_mem_ctx_t;
 
+/**
+ * @brief Check if a VMA lies in a section kept from the previous load
+ *
+ * @param ctx Memory context
+ * @param vma Address in the ELF's VMA space
+ * @return true if relocations at @p vma must be skipped
+ */
+static inline bool elf_port_vma_reused(const elf_port_mem_ctx_t *ctx, uintptr_t vma)
+{
+    for (size_t i = 0; i < ctx->reused_count; i++) {
+        if (vma >= ctx->reused[i].lo && vma < ctx->reused[i].hi) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* ========== Memory Functions (port/elf_loader_mem.c) ========== */
 
 /**
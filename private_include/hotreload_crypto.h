@@ -9,8 +9,10 @@
  * @brief Internal crypto abstraction for HMAC-SHA256 verification
  *
  * This header defines the interface for SHA-256 and HMAC-SHA256 operations
- * used by the hotreload HTTP server. Backend implementations are selected
- * at build time based on the IDF/mbedTLS version:
+ * used by the hotreload HTTP server. Uploads are verified incrementally with
+ * a hotreload_crypto_verify_ctx_t, fed chunk by chunk as data arrives.
+ * Backend implementations are selected at build time based on the
+ * IDF/mbedTLS version:
  *   - IDF 6.x (mbedTLS 4.x): PSA Crypto API  (port/hotreload_crypto_psa.c)
  *   - IDF 5.x (mbedTLS 3.x): Legacy API       (port/hotreload_crypto_mbedcrypto.c)
  */
@@ -28,6 +30,11 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Incremental SHA-256 + HMAC-SHA256 verification context (backend specific)
+ */
+typedef struct hotreload_crypto_verify_ctx hotreload_crypto_verify_ctx_t;
+
 /**
  * @brief Initialize the crypto subsystem
  *
@@ -48,28 +55,57 @@ esp_err_t hotreload_crypto_init(const uint8_t *key, size_t key_len);
 void hotreload_crypto_deinit(void);
 
 /**
- * @brief Verify SHA-256 hash of data
+ * @brief Start incremental verification of SHA-256 and HMAC-SHA256
  *
- * @param data          Input data
- * @param data_len      Length of input data
- * @param expected_hash Expected SHA-256 hash (32 bytes)
- * @return ESP_OK if hash matches, ESP_ERR_INVALID_STATE if mismatch
+ * Both digests are updated from each chunk passed to
+ * hotreload_crypto_verify_update(), so the data is read once and does not
+ * need to be held in memory as a whole.
+ *
+ * @param[out] out_ctx  New context, released by finish or abort
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if out_ctx is NULL
+ *      - ESP_ERR_INVALID_STATE if hotreload_crypto_init() was not called
+ *      - ESP_ERR_NO_MEM if the context cannot be allocated
+ *      - ESP_FAIL on a backend error
+ */
+esp_err_t hotreload_crypto_verify_start(hotreload_crypto_verify_ctx_t **out_ctx);
+
+/**
+ * @brief Add a chunk of data to both digests
+ *
+ * @param ctx       Context from hotreload_crypto_verify_start()
+ * @param data      Chunk of input data
+ * @param data_len  Length of the chunk
+ * @return ESP_OK on success, ESP_FAIL on a backend error
  */
-esp_err_t hotreload_crypto_sha256_verify(const uint8_t *data, size_t data_len,
-                                         const uint8_t *expected_hash);
+esp_err_t hotreload_crypto_verify_update(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *data, size_t data_len);
 
 /**
- * @brief Verify HMAC-SHA256 of data using the key set in hotreload_crypto_init()
+ * @brief Compare both digests with the expected values and release the context
  *
- * Uses constant-time comparison internally.
+ * SHA-256 is checked first, so a corrupted upload is reported as such rather
+ * than as an authentication failure. Uses constant-time comparison internally.
  *
- * @param data          Input data
- * @param data_len      Length of input data
+ * @param ctx           Context from hotreload_crypto_verify_start()
+ * @param expected_hash Expected SHA-256 hash (32 bytes)
  * @param expected_hmac Expected HMAC-SHA256 value (32 bytes)
- * @return ESP_OK if HMAC matches, ESP_FAIL if mismatch
+ * @return
+ *      - ESP_OK if both match
+ *      - ESP_ERR_INVALID_STATE if the SHA-256 hash does not match
+ *      - ESP_FAIL if the HMAC does not match or on a backend error
+ */
+esp_err_t hotreload_crypto_verify_finish(hotreload_crypto_verify_ctx_t *ctx,
+                                         const uint8_t *expected_hash,
+                                         const uint8_t *expected_hmac);
+
+/**
+ * @brief Release a context without checking the digests
+ *
+ * @param ctx  Context from hotreload_crypto_verify_start(), may be NULL
  */
-esp_err_t hotreload_crypto_hmac_verify(const uint8_t *data, size_t data_len,
-                                       const uint8_t *expected_hmac);
+void hotreload_crypto_verify_abort(hotreload_crypto_verify_ctx_t *ctx);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_intr.h
+ * @brief Internal hooks for reloadable interrupt handlers
+ *
+ * Interrupts registered with hotreload_intr_alloc() call the module's
+ * handler directly. These hooks are called by hotreload.c while a new image
+ * is staged, when it is published and when the image is unloaded.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check that a staged image exports every registered handler
+ *
+ * Called in the RESOLVE phase, so that a reload with a missing handler fails
+ * before anything is published.
+ *
+ * @param resolve Returns the address of a symbol table entry in the staged
+ *                image, 0 if the image does not define it
+ * @param ctx Passed to @p resolve
+ * @return
+ *      - ESP_OK: All handlers are defined
+ *      - ESP_ERR_NOT_FOUND: A handler is missing from the staged image
+ */
+esp_err_t hotreload_intr_check(uint32_t (*resolve)(size_t index, void *ctx), void *ctx);
+
+/**
+ * @brief Install the handlers of a newly published image
+ *
+ * Called once the symbol table of the new image is published and before the
+ * previous image is freed. Each vector entry is rewritten on the core that
+ * owns the interrupt, with only that line masked. When this returns, no
+ * handler of the previous image is running. Interrupts the application
+ * disabled stay disabled. Failures are logged; the image is live already.
+ *
+ * @param resolved Symbol table entries of the new image; the handler entries
+ *                 have been checked by hotreload_intr_check()
+ */
+void hotreload_intr_rebind_all(const uint32_t *resolved);
+
+/**
+ * @brief Mask the interrupts of all registered handlers
+ *
+ * Called before the image the handlers live in is unloaded. Registrations
+ * and their enabled state are kept; hotreload_intr_rebind_all() enables the
+ * interrupts again.
+ */
+void hotreload_intr_suspend_all(void);
+
+#ifdef __cplusplus
+}
+#endif
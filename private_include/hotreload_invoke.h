@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_invoke.h
+ * @brief Internal hooks that keep hotreload_invoke() and reloads apart
+ *
+ * hotreload_invoke() calls module code through an address read once from the
+ * symbol table, possibly many times in a row and from another task than the
+ * one reloading. hotreload.c holds this lock while it replaces the table and
+ * frees the code it pointed to.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Wait until no hotreload_invoke() call is running, and block new ones
+ */
+void hotreload_invoke_lock(void);
+
+/**
+ * @brief Let hotreload_invoke() calls run again
+ */
+void hotreload_invoke_unlock(void);
+
+#ifdef __cplusplus
+}
+#endif
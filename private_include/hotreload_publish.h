@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_publish.h
+ * @brief Reading symbol table entries that may not be published yet
+ *
+ * With CONFIG_HOTRELOAD_BACKGROUND_PUBLISH, a load publishes the priority
+ * exports and points every other entry of hotreload_symbol_table to a pending
+ * stub generated by gen_reloadable.py. A call through such an entry waits in
+ * hotreload_pending_wait() until the background task has published the real
+ * address. Code that reads the table to use the address itself, rather than
+ * calling through a stub, gets it from hotreload_published_entry().
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Address of an export in the loaded image
+ *
+ * Waits for the background publish if the entry is not published yet.
+ * Must not be called from an interrupt.
+ *
+ * @param index Index into hotreload_symbol_table
+ * @return Address of the export, 0 if no image is loaded
+ */
+uint32_t hotreload_published_entry(size_t index);
+
+/**
+ * @brief Called by the pending stubs with their symbol index
+ *
+ * Like hotreload_published_entry(), but aborts if the export is not loaded
+ * once the background publish is done.
+ *
+ * @param index Index into hotreload_symbol_table
+ * @return Address of the export, for the stub to call
+ */
+uint32_t hotreload_pending_wait(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_safe.h
+ * @brief Internal hook for committing a reload only when no task uses the old code
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run a function while no other task can run, if no task uses a code range
+ *
+ * Stops the scheduler on all cores, scans the stack of every other task for
+ * words pointing into [lo, hi) and, if none is found, calls @p publish before
+ * letting the tasks run again. @p publish must not block or take locks.
+ *
+ * @param lo First address of the code range
+ * @param hi One past the last address of the code range
+ * @param publish Function called while the tasks are stopped
+ * @param arg Argument for @p publish
+ * @return
+ *      - ESP_OK: Range unused, @p publish was called
+ *      - ESP_ERR_HOTRELOAD_IN_USE: A task stack references the range, @p publish was not called
+ *      - ESP_ERR_NO_MEM: Out of memory
+ *      - Other errors from esp_ipc_call()
+ */
+esp_err_t hotreload_safe_publish(uintptr_t lo, uintptr_t hi, void (*publish)(void *arg), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
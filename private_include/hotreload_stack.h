@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_stack.h
+ * @brief Internal hooks for stack high-water tracking
+ *
+ * The probes are called from the stubs generated by gen_reloadable.py when
+ * CONFIG_HOTRELOAD_STACK_TRACKING is enabled.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Prepare the stack for measuring a call into the module
+ *
+ * @param index Index of the called function in hotreload_symbol_table
+ * @param caller_sp Stack pointer of the caller of the stub
+ */
+void hotreload_stack_probe_enter(uint32_t index, uintptr_t caller_sp);
+
+/**
+ * @brief Record the stack used by a call into the module
+ *
+ * @param index Index of the called function in hotreload_symbol_table
+ * @param caller_sp Stack pointer of the caller of the stub
+ */
+void hotreload_stack_probe_exit(uint32_t index, uintptr_t caller_sp);
+
+/**
+ * @brief Clear the recorded figures
+ *
+ * Called by hotreload.c when a new image is committed.
+ */
+void hotreload_stack_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
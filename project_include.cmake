@@ -43,6 +43,20 @@ endif()
 #       PRIV_REQUIRES esp_system
 #       SRCS reloadable.c
 #   )
+#
+# By default every global function of the module is exported to the main
+# program. To export only a subset, list the functions with EXPORTS and/or
+# name the public headers declaring them with EXPORT_HEADERS:
+#   idf_component_register(
+#       RELOADABLE
+#       ...
+#       EXPORT_HEADERS "include/reloadable.h"
+#       EXPORTS hotreload_benchmark
+#   )
+# Latency-sensitive entry points can be listed with PRIORITY_EXPORTS,
+# highest priority first. They get the first symbol table slots and, with
+# CONFIG_HOTRELOAD_BACKGROUND_PUBLISH, become callable before the others.
+# These keywords are ignored if the component is not reloadable.
 # =============================================================================
 
 # Helper function to check if component should be reloadable via Kconfig
@@ -61,6 +75,27 @@ function(_hotreload_is_in_config_list component_name result_var)
     endif()
 endfunction()
 
+# Remove the hotreload-only keywords (EXPORTS, EXPORT_HEADERS, PRIORITY_EXPORTS) and their
+# values from an idf_component_register() argument list
+function(_hotreload_strip_export_args args_var)
+    set(_idf_keywords SRCS SRC_DIRS EXCLUDE_SRCS INCLUDE_DIRS PRIV_INCLUDE_DIRS LDFRAGMENTS
+        REQUIRES PRIV_REQUIRES REQUIRED_IDF_TARGETS EMBED_FILES EMBED_TXTFILES
+        KCONFIG KCONFIG_PROJBUILD WHOLE_ARCHIVE)
+    set(_result "")
+    set(_skipping FALSE)
+    foreach(_arg IN LISTS ${args_var})
+        if(_arg STREQUAL "EXPORTS" OR _arg STREQUAL "EXPORT_HEADERS" OR _arg STREQUAL "PRIORITY_EXPORTS")
+            set(_skipping TRUE)
+        elseif(_arg IN_LIST _idf_keywords)
+            set(_skipping FALSE)
+        endif()
+        if(NOT _skipping)
+            list(APPEND _result "${_arg}")
+        endif()
+    endforeach()
+    set(${args_var} "${_result}" PARENT_SCOPE)
+endfunction()
+
 # Check if we've already overridden (prevent issues if included twice)
 if(NOT COMMAND _hotreload_idf_component_register_overridden)
     # Marker to indicate we've done the override
@@ -88,7 +123,7 @@ if(NOT COMMAND _hotreload_idf_component_register_overridden)
 
         if(_hreg_is_reloadable)
             # Parse arguments to extract SRCS
-            cmake_parse_arguments(_hreg_parsed "" "" "SRCS;INCLUDE_DIRS;REQUIRES;PRIV_REQUIRES;LDFRAGMENTS;EMBED_FILES;EMBED_TXTFILES" ${_hreg_args})
+            cmake_parse_arguments(_hreg_parsed "" "" "SRCS;INCLUDE_DIRS;REQUIRES;PRIV_REQUIRES;LDFRAGMENTS;EMBED_FILES;EMBED_TXTFILES;EXPORTS;EXPORT_HEADERS;PRIORITY_EXPORTS" ${_hreg_args})
 
             if(NOT DEFINED _hreg_parsed_SRCS OR "${_hreg_parsed_SRCS}" STREQUAL "")
                 message(FATAL_ERROR "Reloadable component '${COMPONENT_NAME}' must have SRCS specified")
@@ -122,9 +157,13 @@ if(NOT COMMAND _hotreload_idf_component_register_overridden)
             _idf_component_register(${_hreg_modified_args})
 
             # Now set up hotreload with the real sources
-            hotreload_setup(SRCS ${_hreg_reloadable_srcs})
+            hotreload_setup(SRCS ${_hreg_reloadable_srcs}
+                EXPORTS ${_hreg_parsed_EXPORTS}
+                EXPORT_HEADERS ${_hreg_parsed_EXPORT_HEADERS}
+                PRIORITY_EXPORTS ${_hreg_parsed_PRIORITY_EXPORTS})
         else()
             # Not a reloadable component - call original directly
+            _hotreload_strip_export_args(_hreg_args)
             _idf_component_register(${_hreg_args})
         endif()
     endmacro()
@@ -136,6 +175,17 @@ endif()
 # Sets up hotreload build infrastructure for a component.
 # Called automatically for RELOADABLE components, or can be called manually.
 #
+# Optional arguments:
+#   PARTITION       Flash partition for the module (default: CONFIG_HOTRELOAD_PARTITION)
+#   EXPORTS         Names of the functions exported to the main program
+#   EXPORT_HEADERS  Public headers whose function prototypes are exported
+#   PRIORITY_EXPORTS  Exported functions to publish first, highest priority first
+#
+# With EXPORTS or EXPORT_HEADERS, the module is compiled with hidden
+# visibility and linked with --gc-sections, so only the exported functions
+# and the code they reach end up in the module, and only they get stubs.
+# Without them, every global function is exported.
+#
 # This function:
 # 1. Builds the component sources as a shared library
 # 2. Generates stubs and symbol table
@@ -149,7 +199,7 @@ function(hotreload_setup)
         HREG
         ""
         "PARTITION"
-        "SRCS"
+        "SRCS;EXPORTS;EXPORT_HEADERS;PRIORITY_EXPORTS"
         ${ARGN}
     )
 
@@ -174,10 +224,60 @@ function(hotreload_setup)
     set(undefined_symbols_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_undefined_symbols.rsp")
     set(ld_script_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}.ld")
     set(stripped_elf_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_stripped.so")
+    set(digest_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_ro_digest.bin")
 
     # Enable shared library support
     set_property(GLOBAL PROPERTY TARGET_SUPPORTS_SHARED_LIBS TRUE)
 
+    # Get Python path
+    idf_build_get_property(python PYTHON)
+
+    # Export list (EXPORTS / EXPORT_HEADERS)
+    set(stub_args "")
+    set(export_compile_options "")
+    set(export_link_options "")
+    if(HREG_EXPORTS OR HREG_EXPORT_HEADERS)
+        set(exports_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_exports.txt")
+        set(exports_rsp_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_exports.rsp")
+        set(signatures_path "${CMAKE_CURRENT_BINARY_DIR}/${COMPONENT_NAME}_signatures.txt")
+
+        set(export_args "")
+        set(export_headers "")
+        foreach(header IN LISTS HREG_EXPORT_HEADERS)
+            get_filename_component(header "${header}" ABSOLUTE BASE_DIR "${CMAKE_CURRENT_SOURCE_DIR}")
+            list(APPEND export_headers "${header}")
+        endforeach()
+        if(export_headers)
+            list(APPEND export_args --headers ${export_headers})
+        endif()
+        if(HREG_EXPORTS OR HREG_PRIORITY_EXPORTS)
+            # Priority exports are exported even if not listed otherwise
+            list(APPEND export_args --exports ${HREG_EXPORTS} ${HREG_PRIORITY_EXPORTS})
+        endif()
+
+        add_custom_command(
+            OUTPUT ${exports_path} ${exports_rsp_path} ${signatures_path}
+            COMMAND ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_exports.py"
+                ${export_args}
+                --output-list ${exports_path}
+                --output-rsp ${exports_rsp_path}
+                --output-signatures ${signatures_path}
+            DEPENDS ${export_headers} "${HOTRELOAD_SCRIPTS_DIR}/gen_exports.py"
+            COMMENT "Generating export list for ${COMPONENT_NAME}"
+        )
+        add_custom_target(gen_${COMPONENT_NAME}_exports
+            DEPENDS ${exports_path} ${exports_rsp_path} ${signatures_path}
+        )
+
+        # Unexported functions become local to the module; --gc-sections
+        # then drops everything not reachable from the exports
+        set(export_compile_options "-fvisibility=hidden" "-ffunction-sections" "-fdata-sections")
+        set(export_link_options "-Wl,--gc-sections" "@${exports_rsp_path}")
+        list(APPEND stub_args --exports-list ${exports_path})
+        # Signatures of the header prototypes, for hotreload_invoke()
+        list(APPEND stub_args --signatures ${signatures_path})
+    endif()
+
     # Build the reloadable ELF (first pass - to extract symbols)
     add_library(${elf_target} SHARED ${HREG_SRCS})
 
@@ -193,20 +293,47 @@ function(hotreload_setup)
     set_target_properties(${elf_target} PROPERTIES LINK_FLAGS "-nostdlib")
     set_target_properties(${elf_target} PROPERTIES LINK_LIBRARIES "")
 
-    # Get Python path
-    idf_build_get_property(python PYTHON)
+    if(export_link_options)
+        target_compile_options(${elf_target} PRIVATE ${export_compile_options})
+        target_link_options(${elf_target} PRIVATE ${export_link_options})
+        set_property(TARGET ${elf_target} APPEND PROPERTY LINK_DEPENDS "${exports_rsp_path}")
+        add_dependencies(${elf_target} gen_${COMPONENT_NAME}_exports)
+    endif()
+
+    if(HREG_PRIORITY_EXPORTS)
+        list(APPEND stub_args --priority-exports ${HREG_PRIORITY_EXPORTS})
+    endif()
+
+    # Stubs that measure stack usage of each call (CONFIG_HOTRELOAD_STACK_TRACKING)
+    if(CONFIG_HOTRELOAD_STACK_TRACKING)
+        list(APPEND stub_args --stack-tracking)
+    endif()
+
+    # Stand-ins for the exports published after the priority ones
+    # (CONFIG_HOTRELOAD_BACKGROUND_PUBLISH)
+    if(CONFIG_HOTRELOAD_BACKGROUND_PUBLISH)
+        list(APPEND stub_args --pending-stubs)
+    endif()
 
     # Generate stubs and symbol table
-    add_custom_target(gen_${COMPONENT_NAME}_stubs COMMAND
-        ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_reloadable.py"
-        --input-elf $<TARGET_FILE:${elf_target}>
-        --output-stubs ${stubs_path}
-        --output-symbol-table ${symbol_table_path}
-        --output-undefined-symbols-rsp-file ${undefined_symbols_path}
-        --nm "${_CMAKE_TOOLCHAIN_PREFIX}nm"
-        --arch ${CONFIG_IDF_TARGET_ARCH}
-        BYPRODUCTS ${stubs_path} ${symbol_table_path} ${undefined_symbols_path}
-        DEPENDS ${elf_target} "${HOTRELOAD_SCRIPTS_DIR}/gen_reloadable.py"
+    # add_custom_command with OUTPUT runs the script only when the first-pass
+    # library or an input changed; the outputs are written only if their
+    # content differs, so the component is not recompiled needlessly.
+    add_custom_command(
+        OUTPUT ${stubs_path} ${symbol_table_path} ${undefined_symbols_path}
+        COMMAND ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_reloadable.py"
+            --input-elf $<TARGET_FILE:${elf_target}>
+            --output-stubs ${stubs_path}
+            --output-symbol-table ${symbol_table_path}
+            --output-undefined-symbols-rsp-file ${undefined_symbols_path}
+            --nm "${_CMAKE_TOOLCHAIN_PREFIX}nm"
+            --arch ${CONFIG_IDF_TARGET_ARCH}
+            ${stub_args}
+        DEPENDS ${elf_target} "${HOTRELOAD_SCRIPTS_DIR}/gen_reloadable.py" ${exports_path} ${signatures_path}
+        COMMENT "Generating stubs and symbol table for ${COMPONENT_NAME}"
+    )
+    add_custom_target(gen_${COMPONENT_NAME}_stubs
+        DEPENDS ${stubs_path} ${symbol_table_path} ${undefined_symbols_path}
     )
 
     # Add generated sources to the component
@@ -217,14 +344,19 @@ function(hotreload_setup)
     # Generate linker script for external symbols
     idf_build_get_property(executable EXECUTABLE GENERATOR_EXPRESSION)
 
-    add_custom_target(gen_${COMPONENT_NAME}_ld_script COMMAND
-        ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_ld_script.py"
-        --main-elf $<TARGET_FILE:$<GENEX_EVAL:${executable}>>
-        --reloadable-elf $<TARGET_FILE:${elf_target}>
-        --output-ld-script ${ld_script_path}
-        --nm "${_CMAKE_TOOLCHAIN_PREFIX}nm"
-        BYPRODUCTS ${ld_script_path}
+    # Re-run nm over the main ELF only when it or the first-pass library was relinked
+    add_custom_command(
+        OUTPUT ${ld_script_path}
+        COMMAND ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_ld_script.py"
+            --main-elf $<TARGET_FILE:$<GENEX_EVAL:${executable}>>
+            --reloadable-elf $<TARGET_FILE:${elf_target}>
+            --output-ld-script ${ld_script_path}
+            --nm "${_CMAKE_TOOLCHAIN_PREFIX}nm"
         DEPENDS ${elf_target} ${executable} "${HOTRELOAD_SCRIPTS_DIR}/gen_ld_script.py"
+        COMMENT "Generating linker script for ${COMPONENT_NAME}"
+    )
+    add_custom_target(gen_${COMPONENT_NAME}_ld_script
+        DEPENDS ${ld_script_path}
     )
 
     # Build final ELF with linker script
@@ -249,6 +381,12 @@ function(hotreload_setup)
         LINK_DEPENDS "${ld_script_path}"
     )
     add_dependencies(${elf_final_target} gen_${COMPONENT_NAME}_ld_script)
+    if(export_link_options)
+        target_compile_options(${elf_final_target} PRIVATE ${export_compile_options})
+        target_link_options(${elf_final_target} PRIVATE ${export_link_options})
+        set_property(TARGET ${elf_final_target} APPEND PROPERTY LINK_DEPENDS "${exports_rsp_path}")
+        add_dependencies(${elf_final_target} gen_${COMPONENT_NAME}_exports)
+    endif()
 
     # Strip the ELF
     # Use add_custom_command with OUTPUT for proper dependency tracking
@@ -262,6 +400,12 @@ function(hotreload_setup)
     endif()
     list(TRANSFORM sections_to_remove PREPEND "--remove-section=")
 
+    # A digest of the read-only sections lets the loader keep them on reload
+    # when only writable data changed (elf_loader_reuse). It is computed on the
+    # stripped ELF, which is what gets loaded, and appended to it as a
+    # non-allocated section.
+    set(objcopy ${_CMAKE_TOOLCHAIN_PREFIX}objcopy)
+
     # add_custom_command with OUTPUT creates proper file-level dependencies
     # When the input (elf_final_target output) changes, this will re-run
     add_custom_command(
@@ -269,7 +413,13 @@ function(hotreload_setup)
         COMMAND ${strip} -o ${stripped_elf_path} $<TARGET_FILE:${elf_final_target}>
             ${sections_to_remove}
             --strip-debug
-        DEPENDS ${elf_final_target}
+        COMMAND ${python} "${HOTRELOAD_SCRIPTS_DIR}/gen_readonly_digest.py"
+            --input-elf ${stripped_elf_path}
+            --output ${digest_path}
+        COMMAND ${objcopy} --add-section .hotreload_ro_digest=${digest_path}
+            ${stripped_elf_path}
+        BYPRODUCTS ${digest_path}
+        DEPENDS ${elf_final_target} "${HOTRELOAD_SCRIPTS_DIR}/gen_readonly_digest.py"
         COMMENT "Stripping ${COMPONENT_NAME} reloadable ELF"
     )
 
@@ -0,0 +1,216 @@
+#! /usr/bin/env python3
+"""Export list generator for reloadable modules.
+
+Collects the functions a reloadable module exports to the main program,
+either from an explicit list of names or from the prototypes declared in
+the component's public headers. Only these functions get a stub and a
+symbol table slot; everything else is hidden and garbage-collected when
+the module is linked.
+
+The signatures of the header prototypes are written to a manifest used by
+hotreload_invoke(): one line per function that hotreload_invoke() can call,
+'<name> <return kind> <argument count>'.
+"""
+
+import argparse
+import re
+import sys
+
+
+def write_if_changed(filepath: str, content: str) -> bool:
+    """
+    Write content to file only if it differs from existing content.
+
+    This avoids unnecessary timestamp updates that would trigger
+    downstream rebuilds when the actual content hasn't changed.
+
+    Returns True if the file was written, False if unchanged.
+    """
+    try:
+        with open(filepath, 'r') as f:
+            existing = f.read()
+        if existing == content:
+            return False
+    except FileNotFoundError:
+        pass
+
+    with open(filepath, 'w') as f:
+        f.write(content)
+    return True
+
+
+# hotreload_invoke() passes at most this many register-sized arguments
+MAX_INVOKE_ARGS = 6
+
+# Types passed in one 32-bit register, by name
+INT_TYPES = {
+    'int8_t', 'int16_t', 'int32_t', 'intptr_t', 'ssize_t', 'ptrdiff_t',
+    'esp_err_t', 'BaseType_t',
+}
+UINT_TYPES = {
+    'uint8_t', 'uint16_t', 'uint32_t', 'uintptr_t', 'size_t', 'bool', '_Bool',
+    'UBaseType_t', 'TickType_t',
+}
+INT_KEYWORDS = {'signed', 'int', 'short', 'char', 'long'}
+QUALIFIERS = {'const', 'volatile', 'restrict', '__restrict', 'register', 'extern', 'inline'}
+
+
+def classify_type(decl: str, has_name: bool) -> str:
+    """
+    Return how a C type is passed: 'void', 'int', 'uint', 'ptr', or None if
+    it does not fit in one 32-bit register or cannot be told from the
+    declaration alone (floats, 64-bit integers, structs and unknown typedefs).
+
+    If has_name is set, decl is a parameter declaration that may end with
+    the parameter name.
+    """
+    if '(' in decl or '*' in decl or '[' in decl:
+        return 'ptr'  # Pointers, arrays and function pointers
+    words = [w for w in re.findall(r'[A-Za-z_]\w*', decl) if w not in QUALIFIERS]
+    if has_name and len(words) > 1 and words[-1] not in INT_KEYWORDS | {'unsigned'}:
+        words = words[:-1]
+    if not words:
+        return None
+    if words == ['void']:
+        return 'void'
+    if words[0] == 'enum':
+        return 'int'
+    if words.count('long') > 1 or words[0] in ('struct', 'union'):
+        return None
+    if 'unsigned' in words and all(w in INT_KEYWORDS | {'unsigned'} for w in words):
+        return 'uint'
+    if all(w in INT_KEYWORDS for w in words):
+        return 'int'
+    if len(words) == 1 and words[0] in INT_TYPES:
+        return 'int'
+    if len(words) == 1 and words[0] in UINT_TYPES:
+        return 'uint'
+    return None
+
+
+def split_params(params: str) -> list:
+    """Split a parameter list at the commas outside nested parentheses."""
+    result = []
+    depth = 0
+    current = ''
+    for c in params:
+        if c == ',' and depth == 0:
+            result.append(current)
+            current = ''
+            continue
+        if c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+        current += c
+    result.append(current)
+    return [p.strip() for p in result]
+
+
+def parse_signature(statement: str, name_start: int, params_start: int) -> tuple:
+    """
+    Return (return kind, argument count) of a prototype, or None if
+    hotreload_invoke() cannot call it.
+    """
+    ret = classify_type(statement[:name_start], False)
+    if ret is None:
+        return None
+
+    depth = 0
+    for end in range(params_start, len(statement)):
+        if statement[end] == '(':
+            depth += 1
+        elif statement[end] == ')':
+            depth -= 1
+            if depth == 0:
+                break
+    else:
+        return None
+    params = statement[params_start + 1:end].strip()
+    if params in ('', 'void'):
+        return ret, 0
+
+    params = split_params(params)
+    if len(params) > MAX_INVOKE_ARGS or '...' in params:
+        return None
+    for param in params:
+        if classify_type(param, True) in (None, 'void'):
+            return None
+    return ret, len(params)
+
+
+def parse_header_functions(path: str) -> list:
+    """
+    Return (name, signature) of the functions declared in a C header, where
+    signature is the result of parse_signature().
+
+    Handles plain C prototypes. Declarations with 'static' (inline helpers),
+    typedefs and function pointer variables are skipped.
+    """
+    with open(path, 'r') as f:
+        text = f.read()
+
+    text = text.replace('\\\n', ' ')
+    text = re.sub(r'/\*.*?\*/', ' ', text, flags=re.S)
+    text = re.sub(r'//[^\n]*', ' ', text)
+    text = re.sub(r'^\s*#[^\n]*', ' ', text, flags=re.M)
+    text = re.sub(r'extern\s+"C"\s*\{', ' ', text)
+    text = re.sub(r'__attribute__\s*\(\(.*?\)\)', ' ', text, flags=re.S)
+
+    # Drop the bodies of structs, enums and inline functions, innermost first
+    while True:
+        text, count = re.subn(r'\{[^{}]*\}', ';', text)
+        if count == 0:
+            break
+    text = text.replace('}', ' ')
+
+    functions = []
+    for statement in text.split(';'):
+        statement = ' '.join(statement.split())
+        if not statement or statement.startswith('typedef') or re.search(r'\bstatic\b', statement):
+            continue
+        # First identifier followed by '(' which does not open a '(*name)' declarator
+        match = re.search(r'\b([A-Za-z_]\w*)\s*\((?!\s*\*)', statement)
+        if match and match.group(1) not in [name for name, _ in functions]:
+            signature = parse_signature(statement, match.start(1), match.end() - 1)
+            functions.append((match.group(1), signature))
+    return functions
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--exports', type=str, nargs='*', default=[], help='Names of exported functions')
+    parser.add_argument('--headers', type=str, nargs='*', default=[], help='Public headers declaring exported functions')
+    parser.add_argument('--output-list', type=str, help='The output file with one exported name per line', required=True)
+    parser.add_argument('--output-rsp', type=str, help='The output linker options RSP file', required=True)
+    parser.add_argument('--output-signatures', type=str, help='The output signature manifest for hotreload_invoke()', required=True)
+    args = parser.parse_args()
+
+    exports = []
+    signatures = {}
+    for header in args.headers:
+        for name, signature in parse_header_functions(header):
+            if name not in exports:
+                exports.append(name)
+                if signature is not None:
+                    signatures[name] = signature
+    for name in args.exports:
+        if name not in exports:
+            exports.append(name)
+
+    if not exports:
+        print('ERROR: the export list of the reloadable module is empty', file=sys.stderr)
+        sys.exit(1)
+
+    write_if_changed(args.output_list, ''.join(f'{name}\n' for name in exports))
+
+    # Exported functions are the roots for --gc-sections. --require-defined
+    # also turns a misspelled or missing export into a link error.
+    write_if_changed(args.output_rsp, ''.join(f'-Wl,--require-defined={name}\n' for name in exports))
+
+    write_if_changed(args.output_signatures, ''.join(
+        f'{name} {signatures[name][0]} {signatures[name][1]}\n' for name in exports if name in signatures))
+
+
+if __name__ == '__main__':
+    main()
@@ -56,8 +56,6 @@ def main():
 
     nm_def_args = [args.nm, '--defined-only', '--format=posix', '--extern-only', args.main_elf]
     nm_def_output = subprocess.check_output(nm_def_args, encoding='utf-8')
-    with open('nm_def_output.txt', 'w') as f:
-        f.write(nm_def_output)
     nm_def_lines = nm_def_output.splitlines()
     def_symbols = []
     for line in nm_def_lines:
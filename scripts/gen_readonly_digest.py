@@ -0,0 +1,129 @@
+#! /usr/bin/env python3
+"""Digest of the read-only part of a reloadable ELF, for reusing it across reloads.
+
+The build embeds one record in the stripped ELF as .hotreload_ro_digest:
+
+    uint8_t  digest[32];    SHA-256 of all read-only sections, see readonly_digest()
+    then, for every read-only allocatable section (.text, .rodata, .plt, ...)
+    in address order:
+    uint32_t addr;          section VMA
+    uint32_t size;          section size
+
+When a new image has the same digest and memory bounds as the one in RAM,
+the loader keeps all of these sections instead of copying and relocating them
+again, and loads only the writable ones (elf_loader_reuse()). That happens
+when an edit changes only the initial values of writable data, or nothing.
+
+The read-only part is compared as a whole. All functions of the module are
+linked into one .text, so a finer granularity would not help: editing any
+function changes .text, and usually its size and the addresses after it.
+"""
+
+import argparse
+import hashlib
+import struct
+
+SHT_PROGBITS = 1
+SHT_SYMTAB = 2
+SHT_RELA = 4
+SHT_NOBITS = 8
+SHT_DYNSYM = 11
+
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+
+SHN_UNDEF = 0
+
+RANGE = struct.Struct('<II')
+
+
+class Section:
+    def __init__(self, data: bytes, header: bytes) -> None:
+        (self.name_off, self.type, self.flags, self.addr, self.offset, self.size,
+         self.link, self.info, self.align, self.entsize) = struct.unpack('<10I', header)
+        self.name = ''
+        self.data = data[self.offset:self.offset + self.size] if self.type != SHT_NOBITS else b''
+
+
+def read_sections(data: bytes) -> list:
+    if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+        raise SystemExit('Not a 32-bit little-endian ELF file')
+    e_shoff, = struct.unpack_from('<I', data, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+
+    sections = [Section(data, data[e_shoff + i * e_shentsize:e_shoff + i * e_shentsize + 40])
+                for i in range(e_shnum)]
+    names = sections[e_shstrndx].data
+    for sec in sections:
+        sec.name = names[sec.name_off:names.index(b'\0', sec.name_off)].decode()
+    return sections
+
+
+def symbol(sections: list, symtab_index: int, sym_index: int) -> bytes:
+    """Value, section and (for undefined symbols) name of a relocation symbol."""
+    symtab = sections[symtab_index]
+    if symtab.type not in (SHT_SYMTAB, SHT_DYNSYM) or sym_index == 0:
+        return b''
+    name_off, value, _, _, _, shndx = struct.unpack_from('<IIIBBH', symtab.data, sym_index * 16)
+    if shndx != SHN_UNDEF:
+        return struct.pack('<IH', value, shndx)
+    strtab = sections[symtab.link].data
+    return strtab[name_off:strtab.index(b'\0', name_off)]
+
+
+def hash_section(h, sections: list, sec: Section) -> None:
+    """
+    Hash the section contents together with every relocation that patches it.
+
+    The loader reapplies the relocations to the bytes copied from flash, so a
+    section only ends up identical in RAM if its contents, the relocations
+    inside it and the values of the symbols they reference are all unchanged.
+    """
+    h.update(sec.name.encode() + b'\0')
+    h.update(struct.pack('<II', sec.addr, sec.size))
+    h.update(sec.data)
+    for rela in sections:
+        if rela.type != SHT_RELA:
+            continue
+        for off in range(0, len(rela.data) - 11, 12):
+            r_offset, r_info, r_addend = struct.unpack_from('<IIi', rela.data, off)
+            if not sec.addr <= r_offset < sec.addr + sec.size:
+                continue
+            h.update(struct.pack('<IIi', r_offset, r_info & 0xff, r_addend))
+            h.update(symbol(sections, rela.link, r_info >> 8))
+
+
+def read_only_sections(sections: list) -> list:
+    """The sections covered by the digest, sorted by address."""
+    return [sec for sec in sorted(sections, key=lambda s: s.addr)
+            if sec.type == SHT_PROGBITS and sec.size != 0
+            and sec.flags & SHF_ALLOC and not sec.flags & SHF_WRITE]
+
+
+def readonly_digest(sections: list) -> bytes:
+    h = hashlib.sha256()
+    for sec in read_only_sections(sections):
+        hash_section(h, sections, sec)
+    return h.digest()
+
+
+def digest_record(sections: list) -> bytes:
+    return readonly_digest(sections) + b''.join(RANGE.pack(sec.addr, sec.size)
+                                                for sec in read_only_sections(sections))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--input-elf', type=str, help='The stripped reloadable ELF file', required=True)
+    parser.add_argument('--output', type=str, help='The output digest record file', required=True)
+    args = parser.parse_args()
+
+    with open(args.input_elf, 'rb') as f:
+        sections = read_sections(f.read())
+
+    with open(args.output, 'wb') as f:
+        f.write(digest_record(sections))
+
+
+if __name__ == '__main__':
+    main()
@@ -38,19 +38,39 @@ def main():
     parser.add_argument('--output-undefined-symbols-rsp-file', type=str, help='The output undefined symbols RSP file', required=True)
     parser.add_argument('--nm', type=str, help='The path to the nm tool', required=True)
     parser.add_argument('--arch', type=str, choices=['xtensa', 'riscv'], help='Architecture the program is built for', required=True)
+    parser.add_argument('--exports-list', type=str, help='File with the names of exported functions, one per line (default: all global functions)')
+    parser.add_argument('--stack-tracking', action='store_true', help='Generate stubs that measure stack usage of each call')
+    parser.add_argument('--signatures', type=str, help='Signature manifest from gen_exports.py, for hotreload_invoke()')
+    parser.add_argument('--priority-exports', type=str, nargs='*', default=[], help='Exported functions published first on load, highest priority first')
+    parser.add_argument('--pending-stubs', action='store_true', help='Generate entries that wait for exports published in the background')
     args = parser.parse_args()
 
 
 
     if args.arch == 'xtensa':
-        generate_function_wrapper = generate_function_wrapper_xtensa
+        if args.stack_tracking:
+            generate_function_wrapper = generate_function_wrapper_xtensa_stack_tracking
+        else:
+            generate_function_wrapper = generate_function_wrapper_xtensa
+        generate_pending_stub = generate_pending_stub_xtensa
     elif args.arch == 'riscv':
-        generate_function_wrapper = generate_function_wrapper_riscv
+        if args.stack_tracking:
+            generate_function_wrapper = generate_function_wrapper_riscv_stack_tracking
+        else:
+            generate_function_wrapper = generate_function_wrapper_riscv
+        generate_pending_stub = generate_pending_stub_riscv
     else:
         raise ValueError(f'Invalid architecture: {args.arch}')
 
 
-    nm_def_args = [args.nm, '--defined-only', '--format=posix', '--extern-only', args.input_elf]
+    if args.exports_list:
+        with open(args.exports_list, 'r') as f:
+            exports = [line.strip() for line in f if line.strip()]
+        # Exports are compiled with hidden visibility and end up as local symbols
+        nm_def_args = [args.nm, '--defined-only', '--format=posix', args.input_elf]
+    else:
+        exports = None
+        nm_def_args = [args.nm, '--defined-only', '--format=posix', '--extern-only', args.input_elf]
     nm_undef_args = [args.nm, '--undefined-only', '--format=posix', args.input_elf]
 
     nm_def_output = subprocess.check_output(nm_def_args, encoding='utf-8')
@@ -64,25 +84,64 @@ def main():
     stubs_buffer = StringIO()
 
     # parse the output of nm
+    def_symbols = []
     def_symbols_lines = nm_def_output.splitlines()
     for line in def_symbols_lines:
         parts = line.split()
         if len(parts) < 2:
             continue
-
-        symbol_name = parts[0]
-        symbol_type = parts[1]
-
+        def_symbols.append((parts[0], parts[1]))
+
+    if exports is not None:
+        # Keep only the exported names, in the order of the export list
+        def_types = {}
+        for symbol_name, symbol_type in def_symbols:
+            def_types.setdefault(symbol_name, symbol_type.upper())
+        missing = [name for name in exports if name not in def_types]
+        if missing:
+            print(f'ERROR: exported symbols not defined in {args.input_elf}: {missing}', file=sys.stderr)
+            sys.exit(1)
+        def_symbols = [(name, def_types[name]) for name in exports]
+
+    for symbol_name, symbol_type in def_symbols:
         if symbol_type == 'T':
             symbol_list.append(symbol_name)
-            symbol_index = len(symbol_list) - 1
-            generate_function_wrapper(table_name, symbol_name, symbol_index, stubs_buffer)
         elif symbol_type == 'D' or symbol_type == 'B':
             print(f'WARNING: {symbol_name} in {args.input_elf} is a data symbol, will not be available in the main program')
 
+    # Priority exports take the first slots of the table, in the given order,
+    # so the loader can resolve and publish them before the rest
+    priority = list(dict.fromkeys(args.priority_exports))
+    missing = [name for name in priority if name not in symbol_list]
+    if missing:
+        print(f'ERROR: priority exports are not exported functions of {args.input_elf}: {missing}', file=sys.stderr)
+        sys.exit(1)
+    symbol_list = priority + [name for name in symbol_list if name not in priority]
+
+    for symbol_index, symbol_name in enumerate(symbol_list):
+        generate_function_wrapper(table_name, symbol_name, symbol_index, stubs_buffer)
+
+    # Entries that stand in for the exports published after the priority
+    # ones, until the background publish is done
+    pending = set()
+    if args.pending_stubs and priority:
+        pending = set(symbol_list[len(priority):])
+    for symbol_index, symbol_name in enumerate(symbol_list):
+        if symbol_name in pending:
+            generate_pending_stub(symbol_name, symbol_index, stubs_buffer)
+
     # Write stubs file only if content changed
     write_if_changed(args.output_stubs, stubs_buffer.getvalue())
 
+    # Signatures for hotreload_invoke(), keyed by name
+    signatures = {}
+    if args.signatures:
+        with open(args.signatures, 'r') as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 3:
+                    signatures[parts[0]] = (parts[1], int(parts[2]))
+
     # Generate symbol table content
     symbol_table_content = f'''#include <stdint.h>
 #include <stddef.h>
@@ -100,6 +159,41 @@ const char *const hotreload_symbol_names[] = {{
 
 // Number of symbols in the table
 const size_t hotreload_symbol_count = {len(symbol_list)};
+
+// The first hotreload_symbol_priority_count entries are priority exports
+const size_t hotreload_symbol_priority_count = {len(priority)};
+
+// Signatures for hotreload_invoke(): argument count in bits 0-3, return
+// kind in bits 4-5 (void, int, unsigned, pointer), 0xff if not callable
+const uint8_t hotreload_symbol_signatures[] = {{
+'''
+    for symbol_name in symbol_list:
+        if symbol_name in signatures:
+            ret, nargs = signatures[symbol_name]
+            code = SIGNATURE_RET_KINDS.index(ret) << 4 | nargs
+            symbol_table_content += f'    0x{code:02x},  // {symbol_name}: {ret} ({nargs} args)\n'
+        else:
+            symbol_table_content += f'    0xff,  // {symbol_name}\n'
+    symbol_table_content += '''    0xff  // Sentinel
+};
+'''
+    if args.pending_stubs:
+        symbol_table_content += '\n'
+        for symbol_name in symbol_list:
+            if symbol_name in pending:
+                symbol_table_content += f'void {PENDING_STUB_PREFIX}{symbol_name}(void);\n'
+        symbol_table_content += '''
+// Entries published in place of the exports that are not published yet,
+// NULL for the priority exports
+void (*const hotreload_symbol_pending[])(void) = {
+'''
+        for symbol_name in symbol_list:
+            if symbol_name in pending:
+                symbol_table_content += f'    {PENDING_STUB_PREFIX}{symbol_name},\n'
+            else:
+                symbol_table_content += f'    NULL,  // {symbol_name}\n'
+        symbol_table_content += '''    NULL  // Sentinel
+};
 '''
 
     # Write symbol table file only if content changed
@@ -112,6 +206,13 @@ const size_t hotreload_symbol_count = {len(symbol_list)};
         parts = line.split()
         symbol_name = parts[0]
         rsp_content += f'-Wl,--undefined={symbol_name}\n'
+    if args.stack_tracking:
+        # The probes are only referenced from the stubs, make sure the
+        # linker pulls them in regardless of library order
+        for probe in STACK_PROBES:
+            rsp_content += f'-Wl,--undefined={probe}\n'
+    if pending:
+        rsp_content += f'-Wl,--undefined={PENDING_WAIT}\n'
 
     # Write RSP file only if content changed
     write_if_changed(args.output_undefined_symbols_rsp_file, rsp_content)
@@ -152,6 +253,109 @@ def generate_function_wrapper_xtensa(table_name, symbol_name, symbol_index, outp
 
 ''')
 
+# Return kinds of the signature manifest, in the order of hotreload_invoke_ret_t
+SIGNATURE_RET_KINDS = ('void', 'int', 'uint', 'ptr')
+
+STACK_PROBE_ENTER = 'hotreload_stack_probe_enter'
+STACK_PROBE_EXIT = 'hotreload_stack_probe_exit'
+STACK_PROBES = (STACK_PROBE_ENTER, STACK_PROBE_EXIT)
+
+# Called by the pending stubs with the symbol index, returns the address
+# once it is published
+PENDING_WAIT = 'hotreload_pending_wait'
+PENDING_STUB_PREFIX = 'hotreload_pending_'
+
+
+def generate_function_wrapper_xtensa_stack_tracking(table_name, symbol_name, symbol_index, output_file):
+    symbol_offset = symbol_index * 4
+    output_file.write(f'''
+.section .text
+.balign 4
+.global {symbol_name}
+.type {symbol_name}, @function
+{symbol_name}:
+    # Trampoline with stack tracking. The probes are called with
+    # (symbol index, caller's stack pointer). call8 preserves a2-a7,
+    # so the incoming arguments survive the enter probe and the return
+    # values survive the exit probe.
+    entry a1, 48
+    movi a10, {symbol_index}
+    addi a11, a1, 48
+    movi a8, {STACK_PROBE_ENTER}
+    callx8 a8
+    # Copy up to 6 arguments from incoming to outgoing registers
+    mov a10, a2
+    mov a11, a3
+    mov a12, a4
+    mov a13, a5
+    mov a14, a6
+    mov a15, a7
+    # Load target address from symbol table and call it
+    movi a8, {table_name}
+    l32i a8, a8, {symbol_offset}
+    callx8 a8
+    # Return values of the target are in a10/a11
+    mov a2, a10
+    mov a3, a11
+    movi a10, {symbol_index}
+    addi a11, a1, 48
+    movi a8, {STACK_PROBE_EXIT}
+    callx8 a8
+    retw.n
+.size {symbol_name}, .-{symbol_name}
+
+''')
+
+
+def generate_function_wrapper_riscv_stack_tracking(table_name, symbol_name, symbol_index, output_file):
+    symbol_offset = symbol_index * 4
+    output_file.write(f'''
+.section .text
+.global {symbol_name}
+.type {symbol_name}, @function
+{symbol_name}:
+    # Trampoline with stack tracking. The probes are called with
+    # (symbol index, caller's stack pointer). Arguments are saved across
+    # the enter probe, return values across the exit probe.
+    addi sp, sp, -48
+    sw ra, 44(sp)
+    sw a0, 0(sp)
+    sw a1, 4(sp)
+    sw a2, 8(sp)
+    sw a3, 12(sp)
+    sw a4, 16(sp)
+    sw a5, 20(sp)
+    sw a6, 24(sp)
+    sw a7, 28(sp)
+    li a0, {symbol_index}
+    addi a1, sp, 48
+    call {STACK_PROBE_ENTER}
+    lw a0, 0(sp)
+    lw a1, 4(sp)
+    lw a2, 8(sp)
+    lw a3, 12(sp)
+    lw a4, 16(sp)
+    lw a5, 20(sp)
+    lw a6, 24(sp)
+    lw a7, 28(sp)
+    la t0, {table_name}
+    lw t0, {symbol_offset}(t0)
+    jalr ra, t0, 0
+    sw a0, 0(sp)
+    sw a1, 4(sp)
+    li a0, {symbol_index}
+    addi a1, sp, 48
+    call {STACK_PROBE_EXIT}
+    lw a0, 0(sp)
+    lw a1, 4(sp)
+    lw ra, 44(sp)
+    addi sp, sp, 48
+    ret
+.size {symbol_name}, .-{symbol_name}
+
+''')
+
+
 def generate_function_wrapper_riscv(table_name, symbol_name, symbol_index, output_file):
     symbol_offset = symbol_index * 4
     output_file.write(f'''
@@ -174,5 +378,75 @@ def generate_function_wrapper_riscv(table_name, symbol_name, symbol_index, outpu
 ''')
 
 
+def generate_pending_stub_xtensa(symbol_name, symbol_index, output_file):
+    output_file.write(f'''
+.section .text
+.balign 4
+.global {PENDING_STUB_PREFIX}{symbol_name}
+.type {PENDING_STUB_PREFIX}{symbol_name}, @function
+{PENDING_STUB_PREFIX}{symbol_name}:
+    # Symbol table entry of an export not published yet. Wait until it
+    # is, then call the published address. call8 preserves a2-a7, so the
+    # incoming arguments survive the wait.
+    entry a1, 48
+    movi a10, {symbol_index}
+    movi a8, {PENDING_WAIT}
+    callx8 a8
+    mov a8, a10
+    # Copy up to 6 arguments from incoming to outgoing registers
+    mov a10, a2
+    mov a11, a3
+    mov a12, a4
+    mov a13, a5
+    mov a14, a6
+    mov a15, a7
+    callx8 a8
+    # Return values of the target are in a10/a11
+    mov a2, a10
+    mov a3, a11
+    retw.n
+.size {PENDING_STUB_PREFIX}{symbol_name}, .-{PENDING_STUB_PREFIX}{symbol_name}
+
+''')
+
+
+def generate_pending_stub_riscv(symbol_name, symbol_index, output_file):
+    output_file.write(f'''
+.section .text
+.global {PENDING_STUB_PREFIX}{symbol_name}
+.type {PENDING_STUB_PREFIX}{symbol_name}, @function
+{PENDING_STUB_PREFIX}{symbol_name}:
+    # Symbol table entry of an export not published yet. Wait until it
+    # is, then jump to the published address with the arguments and
+    # return address restored, so the target returns to our caller.
+    addi sp, sp, -48
+    sw ra, 44(sp)
+    sw a0, 0(sp)
+    sw a1, 4(sp)
+    sw a2, 8(sp)
+    sw a3, 12(sp)
+    sw a4, 16(sp)
+    sw a5, 20(sp)
+    sw a6, 24(sp)
+    sw a7, 28(sp)
+    li a0, {symbol_index}
+    call {PENDING_WAIT}
+    mv t0, a0
+    lw a0, 0(sp)
+    lw a1, 4(sp)
+    lw a2, 8(sp)
+    lw a3, 12(sp)
+    lw a4, 16(sp)
+    lw a5, 20(sp)
+    lw a6, 24(sp)
+    lw a7, 28(sp)
+    lw ra, 44(sp)
+    addi sp, sp, 48
+    jr t0
+.size {PENDING_STUB_PREFIX}{symbol_name}, .-{PENDING_STUB_PREFIX}{symbol_name}
+
+''')
+
+
 if __name__ == '__main__':
     main()
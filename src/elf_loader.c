@@ -16,6 +16,7 @@
  * - port/elf_loader_reloc_riscv.c: RISC-V relocations
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 #include "elf.h"
@@ -31,6 +32,11 @@ static const char *TAG = "elf_loader";
 /* Minimum size for a valid ELF header */
 #define ELF_HEADER_MIN_SIZE sizeof(Elf32_Ehdr)
 
+/* Read-only digest added by the build, see scripts/gen_readonly_digest.py.
+ * A non-allocatable PROGBITS section at address 0, so the section-based
+ * layout and load paths must skip it by name. */
+#define DIGEST_SECTION_NAME ".hotreload_ro_digest"
+
 /**
  * 32-bit aligned memcpy for writing to IRAM
  *
@@ -117,6 +123,68 @@ static size_t elf_loader_read_cb(void *user_ctx, size_t offset, size_t n_bytes,
     return n_bytes;
 }
 
+/**
+ * Copy the read-only digest and section ranges of the ELF to RAM
+ *
+ * elf_loader_reuse() compares them after the next upload has overwritten
+ * the ELF data this context was loaded from. A missing or malformed digest
+ * section only disables reuse.
+ */
+static void read_digest(elf_loader_ctx_t *ctx)
+{
+    elf_parser_handle_t parser = (elf_parser_handle_t)ctx->parser;
+
+    free(ctx->ro_ranges);
+    ctx->ro_ranges = NULL;
+    ctx->ro_range_count = 0;
+
+    elf_iterator_handle_t it;
+    elf_parser_get_sections_it(parser, &it);
+
+    elf_section_handle_t sec;
+    while (elf_section_next(parser, &it, &sec)) {
+        char sec_name[32];
+        if (elf_section_get_name(sec, sec_name, sizeof(sec_name)) != ESP_OK ||
+            strcmp(sec_name, DIGEST_SECTION_NAME) != 0) {
+            continue;
+        }
+
+        /* Digest, then (addr, size) of each read-only section */
+        uintptr_t offset = elf_section_get_offset(sec);
+        uint32_t size = elf_section_get_size(sec);
+        if (size < ELF_LOADER_DIGEST_LEN || (size - ELF_LOADER_DIGEST_LEN) % 8 != 0 ||
+            offset + size > ctx->elf_size) {
+            ESP_LOGW(TAG, "Malformed %s section (size %" PRIu32 "), reuse disabled",
+                     DIGEST_SECTION_NAME, size);
+            return;
+        }
+
+        size_t count = (size - ELF_LOADER_DIGEST_LEN) / 8;
+        if (count == 0) {
+            return;  /* No read-only sections */
+        }
+
+        ctx->ro_ranges = malloc(count * sizeof(*ctx->ro_ranges));
+        if (ctx->ro_ranges == NULL) {
+            ESP_LOGW(TAG, "No memory for the read-only digest, reuse disabled");
+            return;
+        }
+        const uint8_t *rec = (const uint8_t *)ctx->elf_data + offset;
+        memcpy(ctx->ro_digest, rec, ELF_LOADER_DIGEST_LEN);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t range[2];
+            memcpy(range, rec + ELF_LOADER_DIGEST_LEN + i * sizeof(range), sizeof(range));
+            ctx->ro_ranges[i].lo = range[0];
+            ctx->ro_ranges[i].hi = range[0] + range[1];
+        }
+        ctx->ro_range_count = count;
+        ESP_LOGD(TAG, "Read digest of %u read-only sections", (unsigned)count);
+        return;
+    }
+
+    ESP_LOGD(TAG, "No %s section, reuse disabled", DIGEST_SECTION_NAME);
+}
+
 esp_err_t elf_loader_validate_header(const void *elf_data, size_t elf_size)
 {
     if (elf_data == NULL) {
@@ -290,7 +358,8 @@ esp_err_t elf_loader_calculate_memory_layout(elf_loader_ctx_t *ctx,
         }
 
         char sec_name[32];
-        if (elf_section_get_name(sec, sec_name, sizeof(sec_name)) != ESP_OK) {
+        if (elf_section_get_name(sec, sec_name, sizeof(sec_name)) != ESP_OK ||
+            strcmp(sec_name, DIGEST_SECTION_NAME) == 0) {
             continue;
         }
 
@@ -348,6 +417,8 @@ esp_err_t elf_loader_calculate_memory_layout(elf_loader_ctx_t *ctx,
     ESP_LOGI(TAG, "Memory layout: unified vma=0x%x size=%u, text=%u, data=%u",
              (unsigned)vma_min, (unsigned)total_size, (unsigned)ctx->text_size, (unsigned)ctx->data_size);
 
+    read_digest(ctx);
+
     /* Return values if requested (unified layout for API compatibility) */
     if (ram_size_out) {
         *ram_size_out = total_size;
@@ -411,6 +482,69 @@ esp_err_t elf_loader_allocate(elf_loader_ctx_t *ctx)
     return ESP_OK;
 }
 
+esp_err_t elf_loader_reuse(elf_loader_ctx_t *ctx, elf_loader_ctx_t *prev)
+{
+    if (ctx == NULL || prev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (ctx->ram_size == 0 || ctx->ram_base != NULL || ctx->text_base != NULL) {
+        ESP_LOGE(TAG, "Memory layout not calculated or already allocated");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (prev->ram_base == NULL && prev->text_base == NULL) {
+        ESP_LOGE(TAG, "Previous image not allocated");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (ctx->ro_ranges == NULL || prev->ro_ranges == NULL) {
+        ESP_LOGD(TAG, "No read-only digest, not reusing");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    /* Every section must stay where it is. Same bounds and the same
+     * read-only sections, whose addresses the digest covers, leave only
+     * writable sections free to move, and those are always loaded again. */
+    bool same = ctx->heap_caps == prev->heap_caps &&
+                ctx->vma_base == prev->vma_base && ctx->ram_size == prev->ram_size &&
+                ctx->text_vma_lo == prev->text_vma_lo && ctx->text_vma_hi == prev->text_vma_hi &&
+                ctx->data_vma_lo == prev->data_vma_lo && ctx->data_vma_hi == prev->data_vma_hi &&
+                memcmp(ctx->ro_digest, prev->ro_digest, ELF_LOADER_DIGEST_LEN) == 0;
+    if (!same) {
+        ESP_LOGD(TAG, "Read-only sections or layout changed, not reusing");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    size_t reused_size = 0;
+    for (size_t i = 0; i < ctx->ro_range_count; i++) {
+        reused_size += ctx->ro_ranges[i].hi - ctx->ro_ranges[i].lo;
+    }
+
+    /* Take over the memory, prev no longer frees it */
+    ctx->split_alloc = prev->split_alloc;
+    ctx->text_base = prev->text_base;
+    ctx->data_base = prev->data_base;
+    ctx->ram_base = prev->ram_base;
+    ctx->mem_ctx = prev->mem_ctx;
+    ctx->text_mem_ctx = prev->text_mem_ctx;
+    ctx->reused_size = reused_size;
+    ctx->mem_ctx.reused = ctx->ro_ranges;
+    ctx->mem_ctx.reused_count = ctx->ro_range_count;
+
+    prev->split_alloc = false;
+    prev->text_base = NULL;
+    prev->data_base = NULL;
+    prev->ram_base = NULL;
+    memset(&prev->mem_ctx, 0, sizeof(prev->mem_ctx));
+    memset(&prev->text_mem_ctx, 0, sizeof(prev->text_mem_ctx));
+
+    ESP_LOGI(TAG, "Reusing %u read-only sections (%u bytes) from the previous load",
+             (unsigned)ctx->ro_range_count, (unsigned)reused_size);
+
+    return ESP_OK;
+}
+
 esp_err_t elf_loader_load_sections(elf_loader_ctx_t *ctx)
 {
     if (ctx == NULL) {
@@ -430,11 +564,14 @@ esp_err_t elf_loader_load_sections(elf_loader_ctx_t *ctx)
 
     elf_parser_handle_t parser = (elf_parser_handle_t)ctx->parser;
     int items_loaded = 0;
+    int items_reused = 0;
 
-    if (ctx->split_alloc) {
+    if (ctx->split_alloc || ctx->mem_ctx.reused_count > 0) {
         /* Split allocation: load each section individually based on name
          * This is needed because .rodata must go to DRAM even though it's
-         * in an executable segment (ESP32 IRAM doesn't support byte access) */
+         * in an executable segment (ESP32 IRAM doesn't support byte access).
+         * After elf_loader_reuse(), sections are also loaded one by one so
+         * that the ones kept from the previous load can be skipped. */
         elf_iterator_handle_t sec_it;
         elf_parser_get_sections_it(parser, &sec_it);
 
@@ -454,16 +591,28 @@ esp_err_t elf_loader_load_sections(elf_loader_ctx_t *ctx)
             }
 
             char sec_name[32];
-            if (elf_section_get_name(sec, sec_name, sizeof(sec_name)) != ESP_OK) {
+            if (elf_section_get_name(sec, sec_name, sizeof(sec_name)) != ESP_OK ||
+                strcmp(sec_name, DIGEST_SECTION_NAME) == 0) {
+                continue;
+            }
+
+            if (elf_port_vma_reused(&ctx->mem_ctx, addr)) {
+                ESP_LOGD(TAG, "Kept section %s: addr=0x%x size=0x%x",
+                         sec_name, (unsigned)addr, (unsigned)size);
+                items_reused++;
                 continue;
             }
 
-            /* Classify based on section name */
-            bool is_text = is_text_section(sec_name);
+            /* Classify based on section name. Only split text needs word
+             * access: unified memory is written through the data bus, and
+             * rounding up a copy there could clobber a kept section. */
+            bool is_text = ctx->split_alloc && is_text_section(sec_name);
 
             /* Determine destination */
             void *dest;
-            if (is_text) {
+            if (!ctx->split_alloc) {
+                dest = (uint8_t *)ctx->ram_base + (addr - ctx->vma_base);
+            } else if (is_text) {
                 uintptr_t offset = addr - ctx->text_vma_lo;
                 dest = (uint8_t *)ctx->text_base + offset;
             } else {
@@ -547,9 +696,9 @@ esp_err_t elf_loader_load_sections(elf_loader_ctx_t *ctx)
         }
     }
 
-    if (ctx->split_alloc) {
-        ESP_LOGD(TAG, "Loaded %d sections: text at %p, data at %p",
-                 items_loaded, ctx->text_base, ctx->data_base);
+    if (ctx->split_alloc || ctx->mem_ctx.reused_count > 0) {
+        ESP_LOGD(TAG, "Loaded %d sections, kept %d: text at %p, data at %p",
+                 items_loaded, items_reused, ctx->text_base, ctx->data_base);
     } else {
         ESP_LOGD(TAG, "Loaded %d segments into RAM at %p", items_loaded, ctx->ram_base);
     }
@@ -666,6 +815,24 @@ esp_err_t elf_loader_sync_cache(elf_loader_ctx_t *ctx)
     return ESP_OK;
 }
 
+/*
+ * Whether a symbol can be an export. Exports are global functions or
+ * objects, or local ones with hidden visibility: with -fvisibility=hidden
+ * the linker turns the exports into local symbols but keeps STV_HIDDEN.
+ * A file-static of the same name in another translation unit is local with
+ * default visibility and must not be bound instead.
+ */
+static bool is_export_symbol(elf_symbol_handle_t sym)
+{
+    uint8_t type = elf_symbol_get_type(sym);
+    if (type != STT_FUNC && type != STT_OBJECT) {
+        return false;
+    }
+
+    uint8_t bind = elf_symbol_get_bind(sym);
+    return bind == STB_GLOBAL || bind == STB_WEAK || elf_symbol_get_vis(sym) == STV_HIDDEN;
+}
+
 void *elf_loader_get_symbol(elf_loader_ctx_t *ctx, const char *name)
 {
     if (ctx == NULL || name == NULL) {
@@ -694,6 +861,10 @@ void *elf_loader_get_symbol(elf_loader_ctx_t *ctx, const char *name)
     char sym_name[64];
 
     while (elf_symbol_next(parser, &it, &sym)) {
+        if (!is_export_symbol(sym)) {
+            continue;
+        }
+
         esp_err_t err = elf_symbol_get_name(sym, sym_name, sizeof(sym_name));
         if (err != ESP_OK) {
             continue;
@@ -751,6 +922,34 @@ void *elf_loader_get_symbol(elf_loader_ctx_t *ctx, const char *name)
     return NULL;
 }
 
+esp_err_t elf_loader_get_exec_range(const elf_loader_ctx_t *ctx, uintptr_t *lo, uintptr_t *hi)
+{
+    if (ctx == NULL || lo == NULL || hi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uintptr_t base;
+    size_t size;
+    const elf_port_mem_ctx_t *exec_ctx;
+    if (ctx->split_alloc) {
+        base = (uintptr_t)ctx->text_base;
+        size = ctx->text_size;
+        exec_ctx = &ctx->text_mem_ctx;
+    } else {
+        base = (uintptr_t)ctx->ram_base;
+        size = ctx->ram_size;
+        exec_ctx = &ctx->mem_ctx;
+    }
+
+    if (base == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *lo = elf_port_to_exec_addr(exec_ctx, base);
+    *hi = *lo + size;
+    return ESP_OK;
+}
+
 void elf_loader_cleanup(elf_loader_ctx_t *ctx)
 {
     if (ctx == NULL) {
@@ -770,5 +969,6 @@ void elf_loader_cleanup(elf_loader_ctx_t *ctx)
         elf_parser_close((elf_parser_handle_t)ctx->parser);
     }
 
+    free(ctx->ro_ranges);
     memset(ctx, 0, sizeof(*ctx));
 }
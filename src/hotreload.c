@@ -9,11 +9,24 @@
  * @brief Public API for loading and reloading ELF modules
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include "hotreload.h"
 #include "elf_loader.h"
+#include "hotreload_intr.h"
+#include "hotreload_invoke.h"
+#include "hotreload_publish.h"
+#include "hotreload_stack.h"
+#include "hotreload_safe.h"
 #include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
 
 static const char *TAG = "hotreload";
 
@@ -21,166 +34,640 @@ static const char *TAG = "hotreload";
 extern uint32_t hotreload_symbol_table[];
 extern const char *const hotreload_symbol_names[];
 extern const size_t hotreload_symbol_count;
+extern const size_t hotreload_symbol_priority_count;
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+extern void (*const hotreload_symbol_pending[])(void);
+#endif
 
-// Global state for the currently loaded ELF
-static elf_loader_ctx_t s_loader_ctx;
-static esp_partition_mmap_handle_t s_mmap_handle;
+// Number of timing samples kept per phase for pause prediction
+#define HOTRELOAD_HISTORY_LEN 8
+
+// Delay between commit attempts of hotreload_reload_when_safe()
+#define HOTRELOAD_SAFE_RETRY_MS 10
+
+/**
+ * One loaded (or partially loaded) ELF image.
+ *
+ * The parser inside 'loader' keeps a pointer to the loader context, so images
+ * live in fixed slots and are never copied; active/staged are swapped by pointer.
+ */
+typedef struct {
+    elf_loader_ctx_t loader;
+    const esp_partition_t *partition;       // Source partition, NULL if loaded from buffer
+    const void *buffer;                     // Source buffer, when partition is NULL
+    size_t buffer_size;
+    esp_partition_mmap_handle_t mmap_handle;
+    bool mapped;                            // mmap_handle is valid
+    uint32_t heap_caps;
+    size_t image_size;                      // RAM footprint, known after PARSE
+    uint32_t *resolved;                     // Symbol addresses waiting for COMMIT
+    void (*benchmark)(void);                // Optional HOTRELOAD_BENCHMARK_SYMBOL entry point
+} hotreload_image_t;
+
+typedef struct {
+    uint32_t size;
+    uint32_t us;
+} phase_sample_t;
+
+// Global state for the currently loaded ELF and a reload being staged
+static hotreload_image_t s_images[2];
+static hotreload_image_t *s_active = &s_images[0];
+static hotreload_image_t *s_staged = &s_images[1];
 static bool s_is_loaded = false;
-static bool s_loaded_from_buffer = false;  // True if loaded from RAM buffer (no mmap)
-static bool s_update_pending = false;      // Set when partition is updated, cleared on load
+static hotreload_phase_t s_staged_next = HOTRELOAD_PHASE_MAX;  // MAX: nothing staged
+static uint32_t s_staged_generation;
+static volatile uint32_t s_update_generation;  // Incremented on every partition update
+static bool s_update_pending = false;          // Set when partition is updated, cleared on load
+static bool s_commit_when_safe = false;        // COMMIT checks task stacks first (hotreload_reload_when_safe)
+static bool s_retired = false;                 // s_active is unloaded but still in RAM, for ALLOC to take over
+
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+#define BACKGROUND_TASK_STACK 4096
+static SemaphoreHandle_t s_background_idle;    // Given while no background publish is running
+#endif
+
+// Timing history used to predict the duration of each phase
+static phase_sample_t s_history[HOTRELOAD_PHASE_MAX][HOTRELOAD_HISTORY_LEN];
+static hotreload_stats_t s_stats;
+
+static const char *const s_phase_names[HOTRELOAD_PHASE_MAX] = {
+    [HOTRELOAD_PHASE_PARSE] = "parse",
+    [HOTRELOAD_PHASE_ALLOC] = "alloc",
+    [HOTRELOAD_PHASE_LOAD] = "load",
+    [HOTRELOAD_PHASE_RELOCATE] = "relocate",
+    [HOTRELOAD_PHASE_SYNC_CACHE] = "sync_cache",
+    [HOTRELOAD_PHASE_RESOLVE] = "resolve",
+    [HOTRELOAD_PHASE_BENCHMARK] = "benchmark",
+    [HOTRELOAD_PHASE_COMMIT] = "commit",
+};
 
 // Forward declarations
 esp_err_t hotreload_unload(void);
+static void background_wait(void);
+
+// Release everything held by an image and reset the slot
+static void image_release(hotreload_image_t *img)
+{
+    elf_loader_cleanup(&img->loader);
+
+    // Only munmap if we loaded from partition
+    if (img->mapped) {
+        esp_partition_munmap(img->mmap_handle);
+    }
+
+    free(img->resolved);
+    memset(img, 0, sizeof(*img));
+}
+
+// Free an image left in RAM by hotreload_reload() that ALLOC did not take over
+static void retired_release(void)
+{
+    if (s_retired) {
+        image_release(s_active);
+        s_retired = false;
+    }
+}
+
+static void staged_discard(void)
+{
+    image_release(s_staged);
+    s_staged_next = HOTRELOAD_PHASE_MAX;
+}
+
+// Prepare the staged slot for loading from a partition (no work done yet)
+static esp_err_t staged_begin_partition(const hotreload_config_t *config)
+{
+    background_wait();
+
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_staged->partition = partition;
+    s_staged->heap_caps = config->heap_caps;
+    s_staged_next = HOTRELOAD_PHASE_PARSE;
+    s_staged_generation = s_update_generation;
+    return ESP_OK;
+}
 
-// Helper function to perform ELF loading steps
-static esp_err_t do_elf_load(const void *elf_data, size_t elf_size, uint32_t heap_caps)
+static esp_err_t phase_parse(hotreload_image_t *img)
 {
+    const void *elf_data = img->buffer;
+    size_t elf_size = img->buffer_size;
     esp_err_t err;
 
+    if (img->partition != NULL) {
+        // Memory-map the partition
+        err = esp_partition_mmap(img->partition, 0, img->partition->size,
+                                 ESP_PARTITION_MMAP_DATA, &elf_data, &img->mmap_handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to mmap partition: %d", err);
+            return err;
+        }
+        img->mapped = true;
+        elf_size = img->partition->size;
+    }
+
     // Initialize the ELF loader
-    err = elf_loader_init(&s_loader_ctx, elf_data, elf_size);
+    err = elf_loader_init(&img->loader, elf_data, elf_size);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to init ELF loader: %d", err);
         return err;
     }
 
     // Set custom heap_caps if specified
-    s_loader_ctx.heap_caps = heap_caps;
+    img->loader.heap_caps = img->heap_caps;
 
     // Calculate memory layout
-    err = elf_loader_calculate_memory_layout(&s_loader_ctx, NULL, NULL);
+    err = elf_loader_calculate_memory_layout(&img->loader, NULL, NULL);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to calculate memory layout: %d", err);
-        elf_loader_cleanup(&s_loader_ctx);
-        return err;
-    }
-
-    // Allocate RAM
-    err = elf_loader_allocate(&s_loader_ctx);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to allocate memory: %d", err);
-        elf_loader_cleanup(&s_loader_ctx);
-        return err;
-    }
-
-    // Load sections
-    err = elf_loader_load_sections(&s_loader_ctx);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to load sections: %d", err);
-        elf_loader_cleanup(&s_loader_ctx);
         return err;
     }
 
-    // Apply relocations
-    err = elf_loader_apply_relocations(&s_loader_ctx);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to apply relocations: %d", err);
-        elf_loader_cleanup(&s_loader_ctx);
-        return err;
-    }
+    img->image_size = img->loader.ram_size;
+    return ESP_OK;
+}
 
-    // Sync cache
-    err = elf_loader_sync_cache(&s_loader_ctx);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to sync cache: %d", err);
-        elf_loader_cleanup(&s_loader_ctx);
-        return err;
+// Number of exports resolved and published before a load returns.
+// With background publishing, only the priority exports (first in the table).
+static size_t first_pass_count(void)
+{
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    if (hotreload_symbol_priority_count > 0 && hotreload_symbol_priority_count < hotreload_symbol_count) {
+        return hotreload_symbol_priority_count;
     }
+#endif
+    return hotreload_symbol_count;
+}
 
-    // Populate the symbol table
-    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+static void resolve_range(hotreload_image_t *img, size_t first, size_t end)
+{
+    for (size_t i = first; i < end; i++) {
         const char *name = hotreload_symbol_names[i];
         if (name == NULL) {
             break;  // Sentinel reached
         }
 
-        void *addr = elf_loader_get_symbol(&s_loader_ctx, name);
+        void *addr = elf_loader_get_symbol(&img->loader, name);
         if (addr == NULL) {
             ESP_LOGW(TAG, "Symbol '%s' not found in ELF", name);
-            hotreload_symbol_table[i] = 0;
         } else {
-            hotreload_symbol_table[i] = (uint32_t)(uintptr_t)addr;
+            img->resolved[i] = (uint32_t)(uintptr_t)addr;
             ESP_LOGD(TAG, "Symbol[%d] '%s' = %p", (int)i, name, addr);
         }
     }
+}
+
+// Resolve one entry ahead of the background pass, for hotreload_intr_check()
+static uint32_t resolve_entry(size_t index, void *ctx)
+{
+    hotreload_image_t *img = (hotreload_image_t *)ctx;
+    if (img->resolved[index] == 0) {
+        resolve_range(img, index, index + 1);
+    }
+    return img->resolved[index];
+}
+
+static esp_err_t phase_resolve(hotreload_image_t *img)
+{
+    img->resolved = calloc(hotreload_symbol_count ? hotreload_symbol_count : 1, sizeof(uint32_t));
+    if (img->resolved == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    resolve_range(img, 0, first_pass_count());
+
+    img->benchmark = (void (*)(void))elf_loader_get_symbol(&img->loader, HOTRELOAD_BENCHMARK_SYMBOL);
+
+    // Interrupt handlers are rebound on commit, so they must all be there
+    return hotreload_intr_check(resolve_entry, img);
+}
+
+#if CONFIG_HOTRELOAD_BENCHMARK_GATE
+static uint32_t benchmark_once(void (*fn)(void))
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    fn();
+    return esp_cpu_get_cycle_count() - start;
+}
+
+// Compare the staged image against the active one; reject it if it is too slow
+static esp_err_t phase_benchmark(void)
+{
+    hotreload_benchmark_result_t *res = &s_stats.benchmark;
+    res->seq++;
+    res->threshold_pct = CONFIG_HOTRELOAD_BENCHMARK_THRESHOLD;
+    res->old_cycles = 0;
+    res->new_cycles = 0;
+
+    if (!s_is_loaded || s_active->benchmark == NULL || s_staged->benchmark == NULL) {
+        res->verdict = HOTRELOAD_BENCHMARK_SKIPPED;
+        ESP_LOGI(TAG, "Benchmark skipped (no '%s' in %s image)", HOTRELOAD_BENCHMARK_SYMBOL,
+                 !s_is_loaded || s_active->benchmark == NULL ? "old" : "new");
+        return ESP_OK;
+    }
+
+    // Interleave runs so that both images see similar cache and interrupt conditions
+    uint32_t old_min = UINT32_MAX;
+    uint32_t new_min = UINT32_MAX;
+    for (int i = 0; i < CONFIG_HOTRELOAD_BENCHMARK_RUNS; i++) {
+        uint32_t c = benchmark_once(s_active->benchmark);
+        if (c < old_min) {
+            old_min = c;
+        }
+        c = benchmark_once(s_staged->benchmark);
+        if (c < new_min) {
+            new_min = c;
+        }
+    }
+    res->old_cycles = old_min;
+    res->new_cycles = new_min;
+
+    uint64_t allowed = (uint64_t)old_min * (100 + CONFIG_HOTRELOAD_BENCHMARK_THRESHOLD) / 100;
+    if (new_min > allowed) {
+        res->verdict = HOTRELOAD_BENCHMARK_ROLLED_BACK;
+        // Keep the app from retrying the same image at every safe point
+        s_update_pending = false;
+        ESP_LOGW(TAG, "Benchmark: new code slower (%" PRIu32 " vs %" PRIu32 " cycles, threshold %d%%), keeping old code",
+                 new_min, old_min, CONFIG_HOTRELOAD_BENCHMARK_THRESHOLD);
+        return ESP_ERR_HOTRELOAD_SLOWER;
+    }
 
+    res->verdict = HOTRELOAD_BENCHMARK_KEPT;
+    ESP_LOGI(TAG, "Benchmark: %" PRIu32 " -> %" PRIu32 " cycles, keeping new code", old_min, new_min);
     return ESP_OK;
 }
+#endif // CONFIG_HOTRELOAD_BENCHMARK_GATE
 
-esp_err_t hotreload_load(const hotreload_config_t *config)
+// Switch the live symbol table to the staged image
+static void commit_publish(void *arg)
 {
-    if (config == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    size_t first = first_pass_count();
+    memcpy(hotreload_symbol_table, s_staged->resolved, first * sizeof(uint32_t));
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    // The other entries wait in hotreload_pending_wait() until published
+    for (size_t i = first; i < hotreload_symbol_count; i++) {
+        hotreload_symbol_table[i] = (uint32_t)(uintptr_t)hotreload_symbol_pending[i];
     }
+#endif
+}
 
-    if (config->partition_label == NULL) {
-        return ESP_ERR_INVALID_ARG;
+// Make the staged image the active one
+static void commit_swap(void)
+{
+    hotreload_image_t *prev = s_active;
+    s_active = s_staged;
+    s_staged = prev;
+    s_is_loaded = true;
+    s_update_pending = false;  // Clear pending flag after successful load
+
+    s_stats.image_size = s_active->image_size;
+    s_stats.reused_size = s_active->loader.reused_size;
+    s_stats.load_count++;
+    hotreload_stack_reset();
+}
+
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+// Resolve and publish the exports left over by the first pass
+static void background_finish(void)
+{
+    int64_t start = esp_timer_get_time();
+    size_t first = first_pass_count();
+    resolve_range(s_active, first, hotreload_symbol_count);
+    memcpy(&hotreload_symbol_table[first], &s_active->resolved[first],
+           (hotreload_symbol_count - first) * sizeof(uint32_t));
+    free(s_active->resolved);
+    s_active->resolved = NULL;
+
+    s_stats.background_us = (uint32_t)(esp_timer_get_time() - start);
+    ESP_LOGI(TAG, "Published %u remaining exports in %" PRIu32 " us",
+             (unsigned)(hotreload_symbol_count - first), s_stats.background_us);
+}
+
+static void background_task(void *arg)
+{
+    background_finish();
+    xSemaphoreGive(s_background_idle);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t background_start(void)
+{
+    if (s_background_idle == NULL) {
+        s_background_idle = xSemaphoreCreateBinary();  // Created taken
+        if (s_background_idle == NULL) {
+            background_finish();
+            return ESP_OK;
+        }
+    } else {
+        xSemaphoreTake(s_background_idle, 0);
     }
 
-    // Unload previous ELF if loaded
+    if (xTaskCreate(background_task, "hotreload_bg", BACKGROUND_TASK_STACK, NULL,
+                    CONFIG_HOTRELOAD_BACKGROUND_PUBLISH_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "No memory for background publish task, publishing now");
+        background_finish();
+        xSemaphoreGive(s_background_idle);
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+
+static bool background_busy(void)
+{
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    return s_background_idle != NULL && uxSemaphoreGetCount(s_background_idle) == 0;
+#else
+    return false;
+#endif
+}
+
+// Block until a background publish started by the previous load is done
+static void background_wait(void)
+{
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    if (s_background_idle != NULL) {
+        xSemaphoreTake(s_background_idle, portMAX_DELAY);
+        xSemaphoreGive(s_background_idle);
+    }
+#endif
+}
+
+// Publish the staged image and free the previous one
+static esp_err_t phase_commit(void)
+{
+    if (s_commit_when_safe && s_is_loaded) {
+        uintptr_t lo, hi;
+        esp_err_t err = elf_loader_get_exec_range(&s_active->loader, &lo, &hi);
+        if (err != ESP_OK) {
+            return err;
+        }
+        // Fails with ESP_ERR_HOTRELOAD_IN_USE while a task is inside the old code
+        err = hotreload_safe_publish(lo, hi, commit_publish, NULL);
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else {
+        commit_publish(NULL);
+    }
+
+    // Interrupt handlers were resolved by RESOLVE even if not published yet
+    hotreload_intr_rebind_all(s_staged->resolved);
+
     if (s_is_loaded) {
-        hotreload_unload();
+        image_release(s_active);
     }
 
-    // Find the partition
-    const esp_partition_t *partition = esp_partition_find_first(
-        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, config->partition_label);
-    if (partition == NULL) {
-        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
-        return ESP_ERR_NOT_FOUND;
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    if (first_pass_count() < hotreload_symbol_count) {
+        // Only the priority exports are live, the rest point to their
+        // pending stubs until the background task is done
+        commit_swap();
+        return background_start();
     }
+#endif
 
-    // Memory-map the partition
-    const void *mmap_ptr;
-    esp_err_t err = esp_partition_mmap(partition, 0, partition->size,
-                                       ESP_PARTITION_MMAP_DATA, &mmap_ptr, &s_mmap_handle);
+    free(s_staged->resolved);
+    s_staged->resolved = NULL;
+
+    commit_swap();
+    return ESP_OK;
+}
+
+static esp_err_t run_phase(hotreload_phase_t phase)
+{
+    hotreload_image_t *img = s_staged;
+    esp_err_t err;
+
+    switch (phase) {
+    case HOTRELOAD_PHASE_PARSE:
+        return phase_parse(img);
+
+    case HOTRELOAD_PHASE_ALLOC:
+        if (s_retired) {
+            // Keep the sections that did not change, if the layout allows
+            err = elf_loader_reuse(&img->loader, &s_active->loader);
+            retired_release();
+            if (err == ESP_OK) {
+                return ESP_OK;
+            }
+        }
+        err = elf_loader_allocate(&img->loader);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to allocate memory: %d", err);
+        }
+        return err;
+
+    case HOTRELOAD_PHASE_LOAD:
+        err = elf_loader_load_sections(&img->loader);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to load sections: %d", err);
+        }
+        return err;
+
+    case HOTRELOAD_PHASE_RELOCATE:
+        err = elf_loader_apply_relocations(&img->loader);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to apply relocations: %d", err);
+        }
+        return err;
+
+    case HOTRELOAD_PHASE_SYNC_CACHE:
+        err = elf_loader_sync_cache(&img->loader);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to sync cache: %d", err);
+        }
+        return err;
+
+    case HOTRELOAD_PHASE_RESOLVE:
+        return phase_resolve(img);
+
+    case HOTRELOAD_PHASE_BENCHMARK:
+#if CONFIG_HOTRELOAD_BENCHMARK_GATE
+        return phase_benchmark();
+#else
+        return ESP_OK;
+#endif
+
+    case HOTRELOAD_PHASE_COMMIT:
+        // hotreload_invoke() may be running the code the commit frees
+        hotreload_invoke_lock();
+        err = phase_commit();
+        hotreload_invoke_unlock();
+        return err;
+
+    default:
+        return ESP_ERR_INVALID_STATE;
+    }
+}
+
+static void history_record(hotreload_phase_t phase, size_t size, uint32_t us, uint32_t cycles)
+{
+    hotreload_phase_stats_t *st = &s_stats.phase[phase];
+    st->last_cycles = cycles;
+
+    phase_sample_t *sample = &s_history[phase][st->runs % HOTRELOAD_HISTORY_LEN];
+    sample->size = (uint32_t)size;
+    sample->us = us;
+
+    st->last_us = us;
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+    st->runs++;
+}
+
+/**
+ * Predict the duration of a phase for an image of the given size.
+ *
+ * Conservative: every recorded sample is scaled up linearly if the image is
+ * larger than the sampled one (never down), the maximum is taken, and 1/8
+ * is added as margin for cache and heap jitter.
+ */
+static bool history_predict(hotreload_phase_t phase, size_t size, uint32_t *predicted_us)
+{
+    uint32_t runs = s_stats.phase[phase].runs;
+    if (runs == 0) {
+        return false;
+    }
+
+    size_t count = runs < HOTRELOAD_HISTORY_LEN ? runs : HOTRELOAD_HISTORY_LEN;
+    uint64_t worst = 0;
+    for (size_t i = 0; i < count; i++) {
+        const phase_sample_t *sample = &s_history[phase][i];
+        uint64_t est = sample->us;
+        if (sample->size > 0 && size > sample->size) {
+            est = est * size / sample->size;
+        }
+        if (est > worst) {
+            worst = est;
+        }
+    }
+
+    worst += worst / 8;
+    *predicted_us = worst > UINT32_MAX ? UINT32_MAX : (uint32_t)worst;
+    return true;
+}
+
+// Run the next staged phase, record its duration, advance or discard on error.
+// ESP_ERR_HOTRELOAD_IN_USE keeps the image staged so the commit can be retried.
+static esp_err_t staged_step(void)
+{
+    hotreload_phase_t phase = s_staged_next;
+    int64_t start = esp_timer_get_time();
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+
+    esp_err_t err = run_phase(phase);
+    if (err == ESP_ERR_HOTRELOAD_IN_USE) {
+        return err;
+    }
+    if (err != ESP_OK) {
+        staged_discard();
+        return err;
+    }
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    // COMMIT swaps the slots, so take the size from whichever is now active
+    size_t size = (phase == HOTRELOAD_PHASE_COMMIT) ? s_active->image_size : s_staged->image_size;
+    history_record(phase, size, us, cycles);
+    ESP_LOGD(TAG, "Phase %s: %" PRIu32 " us (%u bytes)", s_phase_names[phase], us, (unsigned)size);
+
+    s_staged_next = (hotreload_phase_t)(phase + 1);
+    return ESP_OK;
+}
+
+// Run all remaining staged phases without a deadline
+static esp_err_t staged_finish(void)
+{
+    while (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        esp_err_t err = staged_step();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+// Load from partition next to the active image (if any) and commit
+static esp_err_t load_partition(const hotreload_config_t *config)
+{
+    esp_err_t err = staged_begin_partition(config);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to mmap partition: %d", err);
         return err;
     }
 
     // Perform ELF loading
-    err = do_elf_load(mmap_ptr, partition->size, config->heap_caps);
+    err = staged_finish();
     if (err != ESP_OK) {
-        esp_partition_munmap(s_mmap_handle);
-        s_mmap_handle = 0;
         return err;
     }
 
-    s_is_loaded = true;
-    s_loaded_from_buffer = false;
-    s_update_pending = false;  // Clear pending flag after successful load
     ESP_LOGI(TAG, "Loaded reloadable ELF from partition '%s'", config->partition_label);
 
     return ESP_OK;
 }
 
-bool hotreload_update_available(void)
+esp_err_t hotreload_load(const hotreload_config_t *config)
 {
-    return s_update_pending;
-}
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-esp_err_t hotreload_unload(void)
-{
-    if (!s_is_loaded) {
-        return ESP_ERR_INVALID_STATE;
+    if (config->partition_label == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    elf_loader_cleanup(&s_loader_ctx);
+    // Discard any reload staged by hotreload_reload_within()
+    if (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        staged_discard();
+    }
 
-    // Only munmap if we loaded from partition
-    if (!s_loaded_from_buffer && s_mmap_handle != 0) {
-        esp_partition_munmap(s_mmap_handle);
+    // Unload previous ELF if loaded
+    if (s_is_loaded) {
+        hotreload_unload();
     }
 
-    memset(&s_loader_ctx, 0, sizeof(s_loader_ctx));
-    s_mmap_handle = 0;
+    return load_partition(config);
+}
+
+bool hotreload_update_available(void)
+{
+    return s_update_pending;
+}
+
+// Stop serving the active image. With keep_memory it stays in RAM in its
+// slot, so that the next ALLOC can take it over with elf_loader_reuse().
+static void active_unload(bool keep_memory)
+{
+    hotreload_intr_suspend_all();
+    hotreload_invoke_lock();
+    memset(hotreload_symbol_table, 0, hotreload_symbol_count * sizeof(uint32_t));
+    if (keep_memory) {
+        s_retired = true;
+    } else {
+        image_release(s_active);
+    }
     s_is_loaded = false;
-    s_loaded_from_buffer = false;
+    hotreload_invoke_unlock();
     // Note: don't clear s_update_pending here - it tracks partition state, not load state
 
     ESP_LOGI(TAG, "Unloaded reloadable ELF");
+}
+
+esp_err_t hotreload_unload(void)
+{
+    background_wait();
+
+    if (!s_is_loaded) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
+    active_unload(false);
     return ESP_OK;
 }
 
@@ -190,19 +677,27 @@ esp_err_t hotreload_load_from_buffer(const void *elf_data, size_t elf_size)
         return ESP_ERR_INVALID_ARG;
     }
 
+    background_wait();
+
+    if (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        staged_discard();
+    }
+
     // Unload previous ELF if loaded
     if (s_is_loaded) {
         hotreload_unload();
     }
 
-    esp_err_t err = do_elf_load(elf_data, elf_size, 0);  // Default heap_caps
+    s_staged->buffer = elf_data;
+    s_staged->buffer_size = elf_size;
+    s_staged->heap_caps = 0;  // Default heap_caps
+    s_staged_next = HOTRELOAD_PHASE_PARSE;
+
+    esp_err_t err = staged_finish();
     if (err != ESP_OK) {
         return err;
     }
 
-    s_is_loaded = true;
-    s_loaded_from_buffer = true;
-    s_update_pending = false;  // Clear pending flag after successful load
     ESP_LOGI(TAG, "Loaded reloadable ELF from buffer (%d bytes)", (int)elf_size);
 
     return ESP_OK;
@@ -230,6 +725,12 @@ esp_err_t hotreload_update_partition(const char *partition_label,
         return ESP_ERR_INVALID_SIZE;
     }
 
+    // The background publish of the active image reads symbols from this partition
+    background_wait();
+
+    // Any staged reload reads from this partition and is now stale
+    s_update_generation++;
+
     // Erase partition
     esp_err_t err = esp_partition_erase_range(partition, 0, partition->size);
     if (err != ESP_OK) {
@@ -249,19 +750,43 @@ esp_err_t hotreload_update_partition(const char *partition_label,
     return ESP_OK;
 }
 
+// Whether hotreload_reload() stages the new image next to the active one
+// instead of unloading the active one first. Costs RAM for both images and
+// rules out section reuse, so only done when something needs the old image.
+static bool reload_side_by_side(void)
+{
+#if CONFIG_HOTRELOAD_BENCHMARK_GATE
+    // Benchmarked against the new image before commit
+    return s_active->benchmark != NULL;
+#else
+    return false;
+#endif
+}
+
 esp_err_t hotreload_reload(const hotreload_config_t *config)
 {
     if (config == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // Unload current ELF (if any)
-    if (s_is_loaded) {
-        hotreload_unload();
+    if (config->partition_label == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        staged_discard();
+    }
+
+    // Unload current ELF (if any). Its RAM is freed by ALLOC, after taking
+    // over its read-only sections.
+    if (s_is_loaded && !reload_side_by_side()) {
+        background_wait();
+        active_unload(true);
     }
 
     // Load new ELF
-    esp_err_t err = hotreload_load(config);
+    esp_err_t err = load_partition(config);
+    retired_release();  // Still held if the load failed before ALLOC
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Reload failed: %d", err);
         return err;
@@ -270,3 +795,187 @@ esp_err_t hotreload_reload(const hotreload_config_t *config)
     ESP_LOGI(TAG, "Reload complete");
     return ESP_OK;
 }
+
+esp_err_t hotreload_reload_within(const hotreload_config_t *config, uint32_t budget_us,
+                                  hotreload_commit_result_t *result)
+{
+    if (config == NULL || config->partition_label == NULL || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start = esp_timer_get_time();
+    memset(result, 0, sizeof(*result));
+
+    // Do not block on the background publish of the previous load
+    if (background_busy()) {
+        result->status = HOTRELOAD_COMMIT_DEFERRED;
+        result->reason = HOTRELOAD_DEFER_BUSY;
+        result->next_phase = s_staged_next;
+        return ESP_OK;
+    }
+
+    // The partition was rewritten under the staged image, start over
+    if (s_staged_next != HOTRELOAD_PHASE_MAX && s_staged_generation != s_update_generation) {
+        ESP_LOGW(TAG, "Partition updated during staged reload, restarting");
+        staged_discard();
+    }
+
+    if (s_staged_next == HOTRELOAD_PHASE_MAX) {
+        esp_err_t err = staged_begin_partition(config);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    bool progressed = false;
+    while (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        hotreload_phase_t phase = s_staged_next;
+        // Size is unknown before PARSE, assume it matches the previous image
+        size_t size = s_staged->image_size ? s_staged->image_size : s_stats.image_size;
+        uint32_t predicted_us;
+        uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+
+        if (!history_predict(phase, size, &predicted_us)) {
+            result->reason = HOTRELOAD_DEFER_NO_HISTORY;
+            result->predicted_us = 0;
+            break;
+        }
+        if (elapsed_us + (uint64_t)predicted_us > budget_us) {
+            result->reason = HOTRELOAD_DEFER_OVER_BUDGET;
+            result->predicted_us = predicted_us;
+            break;
+        }
+
+        esp_err_t err = staged_step();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Reload failed in phase %s: %d", s_phase_names[phase], err);
+            return err;
+        }
+        progressed = true;
+    }
+
+    result->next_phase = s_staged_next;
+    result->elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+
+    if (s_staged_next == HOTRELOAD_PHASE_MAX) {
+        result->status = HOTRELOAD_COMMIT_DONE;
+        ESP_LOGI(TAG, "Reload complete (%" PRIu32 " us in last step)", result->elapsed_us);
+    } else {
+        result->status = progressed ? HOTRELOAD_COMMIT_IN_PROGRESS : HOTRELOAD_COMMIT_DEFERRED;
+        ESP_LOGD(TAG, "Reload stopped before phase %s: predicted %" PRIu32 " us, budget %" PRIu32 " us",
+                 s_phase_names[s_staged_next], result->predicted_us, budget_us);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t hotreload_reload_when_safe(const hotreload_config_t *config, uint32_t timeout_ms)
+{
+    if (config == NULL || config->partition_label == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        staged_discard();
+    }
+
+    // The current image stays loaded: its code range is what the commit checks
+    esp_err_t err = staged_begin_partition(config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    uint32_t retries = 0;
+    s_commit_when_safe = true;
+    while (s_staged_next != HOTRELOAD_PHASE_MAX) {
+        err = staged_step();
+        if (err == ESP_ERR_HOTRELOAD_IN_USE) {
+            if (esp_timer_get_time() >= deadline) {
+                staged_discard();
+                err = ESP_ERR_TIMEOUT;
+                break;
+            }
+            retries++;
+            vTaskDelay(pdMS_TO_TICKS(HOTRELOAD_SAFE_RETRY_MS));
+            continue;
+        }
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+    s_commit_when_safe = false;
+
+    if (err == ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "Reload timed out: code still in use after %" PRIu32 " retries", retries);
+        return err;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Reload failed: %d", err);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Reload complete (%" PRIu32 " retries)", retries);
+    return ESP_OK;
+}
+
+uint32_t hotreload_published_entry(size_t index)
+{
+    if (index >= first_pass_count()) {
+        background_wait();
+    }
+    return hotreload_symbol_table[index];
+}
+
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+uint32_t hotreload_pending_wait(size_t index)
+{
+    uint32_t addr = hotreload_published_entry(index);
+    if (addr == 0 || addr == (uint32_t)(uintptr_t)hotreload_symbol_pending[index]) {
+        ESP_LOGE(TAG, "'%s' called while not loaded", hotreload_symbol_names[index]);
+        abort();
+    }
+    return addr;
+}
+#endif
+
+esp_err_t hotreload_wait_published(uint32_t timeout_ms)
+{
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+    if (s_background_idle != NULL) {
+        if (xSemaphoreTake(s_background_idle, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        xSemaphoreGive(s_background_idle);
+    }
+    return ESP_OK;
+#else
+    return ESP_OK;
+#endif
+}
+
+bool hotreload_reload_in_progress(void)
+{
+    return s_staged_next != HOTRELOAD_PHASE_MAX;
+}
+
+esp_err_t hotreload_reload_abort(void)
+{
+    if (s_staged_next == HOTRELOAD_PHASE_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    staged_discard();
+    ESP_LOGI(TAG, "Staged reload discarded");
+    return ESP_OK;
+}
+
+esp_err_t hotreload_get_stats(hotreload_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = s_stats;
+    return ESP_OK;
+}
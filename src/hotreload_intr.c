@@ -0,0 +1,284 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_intr.c
+ * @brief Interrupt handlers that live in the reloadable module
+ *
+ * The interrupt is allocated once, with the module's handler installed in
+ * the vector table directly; there is no stub on the interrupt path. On
+ * reload, the vector entry is rewritten on the CPU that owns the interrupt:
+ * the line is masked, esp_cpu_intr_set_handler() installs the handler of the
+ * new image, and the line is unmasked again. The rewrite runs in task context
+ * on that CPU, so no handler of the previous image is running there once it
+ * returns. Shared interrupts dispatch through a list owned by esp_intr_alloc()
+ * and cannot be rebound this way, so they are rejected.
+ *
+ * While no image is loaded, the interrupts are masked.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "esp_intr_alloc.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "hotreload.h"
+#include "hotreload_intr.h"
+#include "hotreload_publish.h"
+#if !CONFIG_FREERTOS_UNICORE
+#include "esp_ipc.h"
+#endif
+
+static const char *TAG = "hotreload_intr";
+
+// Symbol table - defined by the reloadable component
+extern const char *const hotreload_symbol_names[];
+extern const size_t hotreload_symbol_count;
+
+struct hotreload_intr_s {
+    size_t symbol_index;        // Index into hotreload_symbol_table
+    void *arg;
+    int cpu;                    // Core the interrupt is allocated on
+    int intno;                  // CPU interrupt line on that core
+    intr_handle_t handle;
+    bool enabled;               // State requested by the application
+    bool suspended;             // Masked while the handler is not loaded
+    struct hotreload_intr_s *next;
+};
+
+static struct hotreload_intr_s *s_intr_list;
+
+typedef enum {
+    INTR_OP_ENABLE,
+    INTR_OP_DISABLE,
+    INTR_OP_REBIND,
+} intr_op_t;
+
+typedef struct {
+    struct hotreload_intr_s *rec;
+    intr_op_t op;
+    intr_handler_t handler;     // INTR_OP_REBIND only
+    esp_err_t err;
+} intr_op_args_t;
+
+static void intr_op_on_this_core(void *arg)
+{
+    intr_op_args_t *args = (intr_op_args_t *)arg;
+    struct hotreload_intr_s *rec = args->rec;
+
+    switch (args->op) {
+    case INTR_OP_ENABLE:
+        args->err = esp_intr_enable(rec->handle);
+        break;
+    case INTR_OP_DISABLE:
+        args->err = esp_intr_disable(rec->handle);
+        break;
+    case INTR_OP_REBIND:
+        // Mask only this line while its vector entry is rewritten
+        args->err = esp_intr_disable(rec->handle);
+        if (args->err != ESP_OK) {
+            break;
+        }
+        esp_cpu_intr_set_handler(rec->intno, (esp_cpu_intr_handler_t)args->handler, rec->arg);
+        if (rec->enabled) {
+            args->err = esp_intr_enable(rec->handle);
+        }
+        break;
+    }
+}
+
+// Run an operation on the core the interrupt was allocated on. Non-shared
+// interrupts can only be masked, unmasked and rebound from their own core.
+static esp_err_t intr_op(struct hotreload_intr_s *rec, intr_op_t op, intr_handler_t handler)
+{
+    intr_op_args_t args = {
+        .rec = rec,
+        .op = op,
+        .handler = handler,
+        .err = ESP_OK,
+    };
+
+#if !CONFIG_FREERTOS_UNICORE
+    if (rec->cpu != esp_cpu_get_core_id()) {
+        esp_err_t err = esp_ipc_call_blocking(rec->cpu, intr_op_on_this_core, &args);
+        if (err != ESP_OK) {
+            return err;
+        }
+        return args.err;
+    }
+#endif
+    intr_op_on_this_core(&args);
+    return args.err;
+}
+
+static bool find_symbol(const char *name, size_t *index)
+{
+    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+        if (hotreload_symbol_names[i] == NULL) {
+            break;  // Sentinel reached
+        }
+        if (strcmp(hotreload_symbol_names[i], name) == 0) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_registered(hotreload_intr_handle_t handle)
+{
+    for (struct hotreload_intr_s *rec = s_intr_list; rec != NULL; rec = rec->next) {
+        if (rec == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t hotreload_intr_alloc(int source, int flags, const char *handler_name,
+                               void *arg, hotreload_intr_handle_t *ret_handle)
+{
+    if (handler_name == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (flags & ESP_INTR_FLAG_SHARED) {
+        ESP_LOGE(TAG, "Shared interrupts cannot be rebound on reload");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    size_t index;
+    if (!find_symbol(handler_name, &index)) {
+        ESP_LOGE(TAG, "'%s' is not an exported symbol of the reloadable module", handler_name);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Not a pending stub: the handler must not wait in an interrupt
+    intr_handler_t handler = (intr_handler_t)(uintptr_t)hotreload_published_entry(index);
+    if (handler == NULL) {
+        ESP_LOGE(TAG, "'%s' is not loaded", handler_name);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    struct hotreload_intr_s *rec = heap_caps_calloc(1, sizeof(*rec), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (rec == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    rec->symbol_index = index;
+    rec->arg = arg;
+    rec->enabled = !(flags & ESP_INTR_FLAG_INTRDISABLED);
+
+    esp_err_t err = esp_intr_alloc(source, flags, handler, arg, &rec->handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate interrupt for '%s': %d", handler_name, err);
+        free(rec);
+        return err;
+    }
+    rec->cpu = esp_intr_get_cpu(rec->handle);
+    rec->intno = esp_intr_get_intno(rec->handle);
+
+    rec->next = s_intr_list;
+    s_intr_list = rec;
+    *ret_handle = rec;
+
+    ESP_LOGD(TAG, "Interrupt source %d bound to '%s' on core %d, line %d",
+             source, handler_name, rec->cpu, rec->intno);
+    return ESP_OK;
+}
+
+esp_err_t hotreload_intr_enable(hotreload_intr_handle_t handle)
+{
+    if (handle == NULL || !is_registered(handle)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->enabled = true;
+    if (handle->suspended) {
+        return ESP_OK;  // Enabled by hotreload_intr_rebind_all() once loaded
+    }
+    return intr_op(handle, INTR_OP_ENABLE, NULL);
+}
+
+esp_err_t hotreload_intr_disable(hotreload_intr_handle_t handle)
+{
+    if (handle == NULL || !is_registered(handle)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->enabled = false;
+    if (handle->suspended) {
+        return ESP_OK;
+    }
+    return intr_op(handle, INTR_OP_DISABLE, NULL);
+}
+
+esp_err_t hotreload_intr_free(hotreload_intr_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct hotreload_intr_s **link = &s_intr_list;
+    while (*link != NULL && *link != handle) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *link = handle->next;
+
+    // esp_intr_free() disables the interrupt first and handles the other core
+    esp_err_t err = esp_intr_free(handle->handle);
+    free(handle);
+    return err;
+}
+
+esp_err_t hotreload_intr_check(uint32_t (*resolve)(size_t index, void *ctx), void *ctx)
+{
+    esp_err_t ret = ESP_OK;
+
+    for (struct hotreload_intr_s *rec = s_intr_list; rec != NULL; rec = rec->next) {
+        if (resolve(rec->symbol_index, ctx) == 0) {
+            ESP_LOGE(TAG, "Interrupt handler '%s' missing from new image",
+                     hotreload_symbol_names[rec->symbol_index]);
+            ret = ESP_ERR_NOT_FOUND;
+        }
+    }
+
+    return ret;
+}
+
+void hotreload_intr_rebind_all(const uint32_t *resolved)
+{
+    for (struct hotreload_intr_s *rec = s_intr_list; rec != NULL; rec = rec->next) {
+        intr_handler_t handler = (intr_handler_t)(uintptr_t)resolved[rec->symbol_index];
+        esp_err_t err = intr_op(rec, INTR_OP_REBIND, handler);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to rebind interrupt for '%s': %d",
+                     hotreload_symbol_names[rec->symbol_index], err);
+        }
+        rec->suspended = false;
+    }
+}
+
+void hotreload_intr_suspend_all(void)
+{
+    for (struct hotreload_intr_s *rec = s_intr_list; rec != NULL; rec = rec->next) {
+        if (rec->suspended) {
+            continue;
+        }
+        rec->suspended = true;
+        if (rec->enabled) {
+            esp_err_t err = intr_op(rec, INTR_OP_DISABLE, NULL);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to disable interrupt for '%s': %d",
+                         hotreload_symbol_names[rec->symbol_index], err);
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_invoke.c
+ * @brief Call exported functions of the module by index, for benchmarking
+ *
+ * gen_exports.py records the signature of every function declared in the
+ * component's EXPORT_HEADERS, and gen_reloadable.py turns it into
+ * hotreload_symbol_signatures[], one byte per symbol table entry. Functions
+ * taking only register-sized integer or pointer arguments can then be called
+ * through a single prototype: on both Xtensa and RISC-V the first six such
+ * arguments go in registers, so passing unused ones is harmless.
+ *
+ * The calls run under a lock that hotreload.c also takes to publish a new
+ * image or unload the current one, so the code being timed is never freed
+ * under it. A reload waits for the timed loop to finish.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "hotreload.h"
+#include "hotreload_invoke.h"
+#include "hotreload_publish.h"
+
+static const char *TAG = "hotreload_invoke";
+
+// Symbol table - defined by the reloadable component
+extern const char *const hotreload_symbol_names[];
+extern const size_t hotreload_symbol_count;
+extern const uint8_t hotreload_symbol_signatures[];
+
+// Signature byte layout, see gen_reloadable.py
+#define SIGNATURE_UNKNOWN       0xff
+#define SIGNATURE_NARGS(sig)    ((sig) & 0x0f)
+#define SIGNATURE_RET(sig)      ((hotreload_invoke_ret_t)(((sig) >> 4) & 0x03))
+
+typedef uint32_t (*invoke_fn_t)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE s_lock_init = portMUX_INITIALIZER_UNLOCKED;
+
+void hotreload_invoke_lock(void)
+{
+    // Created on first use; the reloading task and the caller may race here
+    taskENTER_CRITICAL(&s_lock_init);
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    }
+    taskEXIT_CRITICAL(&s_lock_init);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+void hotreload_invoke_unlock(void)
+{
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t hotreload_invoke(size_t index, const uint32_t *args, size_t nargs, uint32_t repeat,
+                           hotreload_invoke_result_t *result)
+{
+    if (result == NULL || repeat == 0 || nargs > HOTRELOAD_INVOKE_MAX_ARGS || (nargs > 0 && args == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (index >= hotreload_symbol_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const char *name = hotreload_symbol_names[index];
+    uint8_t sig = hotreload_symbol_signatures[index];
+    if (sig == SIGNATURE_UNKNOWN) {
+        ESP_LOGE(TAG, "No supported signature recorded for '%s'", name);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (SIGNATURE_NARGS(sig) != nargs) {
+        ESP_LOGE(TAG, "'%s' takes %d arguments, got %d", name, SIGNATURE_NARGS(sig), (int)nargs);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Held until the last call returns: the image cannot be replaced meanwhile
+    hotreload_invoke_lock();
+    // The published address, so the timing does not include the wait
+    uint32_t addr = hotreload_published_entry(index);
+    if (addr == 0) {
+        hotreload_invoke_unlock();
+        ESP_LOGE(TAG, "'%s' is not loaded", name);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t a[HOTRELOAD_INVOKE_MAX_ARGS] = {0};
+    for (size_t i = 0; i < nargs; i++) {
+        a[i] = args[i];
+    }
+
+    invoke_fn_t fn = (invoke_fn_t)(uintptr_t)addr;
+    uint32_t ret = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < repeat; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        ret = fn(a[0], a[1], a[2], a[3], a[4], a[5]);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < min) {
+            min = cycles;
+        }
+        if (cycles > max) {
+            max = cycles;
+        }
+        total += cycles;
+    }
+    hotreload_invoke_unlock();
+
+    result->ret_type = SIGNATURE_RET(sig);
+    result->result = result->ret_type == HOTRELOAD_INVOKE_RET_VOID ? 0 : ret;
+    result->calls = repeat;
+    result->min_cycles = min;
+    result->mean_cycles = (uint32_t)(total / repeat);
+    result->max_cycles = max;
+    return ESP_OK;
+}
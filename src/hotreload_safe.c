@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_safe.c
+ * @brief Commit a reload only when no task is executing the old code
+ *
+ * hotreload_reload_when_safe() publishes the new symbol table through
+ * hotreload_safe_publish(). The scheduler is stopped on every core, and the
+ * saved stack of every other task is scanned for words pointing into the
+ * text of the loaded image. A task preempted or blocked inside the module
+ * always has such a word on its stack: its saved program counter or a
+ * return address. If none is found, the table is switched before the tasks
+ * can run again and the old code is unreachable once the scheduler resumes.
+ *
+ * The scan is conservative: a stale value in a live stack frame can also
+ * match, which only delays the commit until the next retry. Calls made from
+ * interrupt handlers are not covered.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#if __has_include("esp_private/freertos_debug.h")
+#include "esp_private/freertos_debug.h"
+#else
+#include "freertos/task_snapshot.h"
+#endif
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "hotreload.h"
+#include "hotreload_safe.h"
+
+#if !CONFIG_FREERTOS_UNICORE
+#include "esp_ipc.h"
+#endif
+
+static const char *TAG = "hotreload_safe";
+
+// Headroom for tasks created between sizing the array and stopping the scheduler
+#define SNAPSHOT_SLACK  4
+
+#if !CONFIG_FREERTOS_UNICORE
+static volatile bool s_park_request;
+static volatile bool s_parked;
+static volatile TaskHandle_t s_parking_task;
+
+// Runs in the IPC task of the other core: stop scheduling there until released
+static void park_other_core(void *arg)
+{
+    vTaskSuspendAll();
+    s_parking_task = xTaskGetCurrentTaskHandle();
+    s_parked = true;
+    while (s_park_request) {
+    }
+    xTaskResumeAll();
+    s_parked = false;
+}
+#endif
+
+static inline bool word_in_range(uint32_t word, uintptr_t lo, uintptr_t hi)
+{
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    // Windowed ABI return addresses carry the call increment in the top two
+    // bits; the real address shares them with the code range
+    word = (word & 0x3fffffffu) | (lo & 0xc0000000u);
+#endif
+    return word >= lo && word < hi;
+}
+
+// Index of the first task whose saved stack references [lo, hi), or -1
+static int scan_snapshots(const TaskSnapshot_t *snaps, UBaseType_t count, TaskHandle_t skip_a,
+                          TaskHandle_t skip_b, uintptr_t lo, uintptr_t hi)
+{
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskSnapshot_t *snap = &snaps[i];
+        // Running tasks: their saved stack pointer is stale
+        if ((TaskHandle_t)snap->pxTCB == skip_a || (TaskHandle_t)snap->pxTCB == skip_b) {
+            continue;
+        }
+
+        const uint32_t *p = (const uint32_t *)((uintptr_t)snap->pxTopOfStack & ~(uintptr_t)3);
+        const uint32_t *end = (const uint32_t *)snap->pxEndOfStack;
+        for (; p <= end; p++) {
+            if (word_in_range(*p, lo, hi)) {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+esp_err_t hotreload_safe_publish(uintptr_t lo, uintptr_t hi, void (*publish)(void *arg), void *arg)
+{
+    if (publish == NULL || hi <= lo) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + SNAPSHOT_SLACK;
+    TaskSnapshot_t *snaps = malloc(capacity * sizeof(*snaps));
+    if (snaps == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    TaskHandle_t parking_task = NULL;
+#if !CONFIG_FREERTOS_UNICORE
+    // If this task migrates before the call lands, the IPC task preempts it
+    // on the target core and it continues on the other one, so the two
+    // cores still end up one parked and one scanning.
+    s_parked = false;
+    s_park_request = true;
+    esp_err_t err = esp_ipc_call(!esp_cpu_get_core_id(), park_other_core, NULL);
+    if (err != ESP_OK) {
+        s_park_request = false;
+        free(snaps);
+        return err;
+    }
+    while (!s_parked) {
+    }
+    parking_task = s_parking_task;
+#endif
+
+    vTaskSuspendAll();
+
+    UBaseType_t tcb_size;
+    UBaseType_t count = 0;
+    int busy = -1;
+    char busy_name[configMAX_TASK_NAME_LEN] = "";
+    bool complete = uxTaskGetNumberOfTasks() <= capacity;
+    if (complete) {
+        count = uxTaskGetSnapshotAll(snaps, capacity, &tcb_size);
+        busy = scan_snapshots(snaps, count, xTaskGetCurrentTaskHandle(), parking_task, lo, hi);
+        if (busy < 0) {
+            publish(arg);
+        } else {
+            // Copied now: the task may be deleted once the scheduler runs again
+            strlcpy(busy_name, pcTaskGetName((TaskHandle_t)snaps[busy].pxTCB), sizeof(busy_name));
+        }
+    }
+
+    xTaskResumeAll();
+
+#if !CONFIG_FREERTOS_UNICORE
+    s_park_request = false;
+    while (s_parked) {
+    }
+#endif
+
+    esp_err_t ret = ESP_OK;
+    if (!complete) {
+        ESP_LOGD(TAG, "Task list grew during the scan, retrying later");
+        ret = ESP_ERR_HOTRELOAD_IN_USE;
+    } else if (busy >= 0) {
+        ESP_LOGD(TAG, "Task '%s' is executing reloadable code", busy_name);
+        ret = ESP_ERR_HOTRELOAD_IN_USE;
+    }
+
+    free(snaps);
+    return ret;
+}
@@ -9,7 +9,11 @@
  * @brief HTTP server for receiving ELF updates over the network
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
 #include "hotreload.h"
 #include "hotreload_crypto.h"
 #include "hotreload_hmac_key.h"
@@ -60,9 +64,9 @@ static void send_403(httpd_req_t *req, const char *message)
     httpd_resp_sendstr(req, message);
 }
 
-// Verify X-Hotreload-SHA256 and X-Hotreload-HMAC headers against body
-static esp_err_t verify_upload_hmac(httpd_req_t *req,
-                                     const uint8_t *body, size_t body_len)
+// Read the X-Hotreload-SHA256 and X-Hotreload-HMAC headers of an upload
+static esp_err_t read_upload_digests(httpd_req_t *req, uint8_t *expected_sha256,
+                                     uint8_t *expected_hmac)
 {
     char sha256_hex[65] = {0};  // 64 hex chars + null
     char hmac_hex[65] = {0};
@@ -83,29 +87,30 @@ static esp_err_t verify_upload_hmac(httpd_req_t *req,
     }
 
     // Decode hex
-    uint8_t expected_sha256[HOTRELOAD_SHA256_LEN];
-    uint8_t expected_hmac[HOTRELOAD_HMAC_LEN];
-
-    if (hex_decode(sha256_hex, 64, expected_sha256, sizeof(expected_sha256)) != HOTRELOAD_SHA256_LEN) {
+    if (hex_decode(sha256_hex, 64, expected_sha256, HOTRELOAD_SHA256_LEN) != HOTRELOAD_SHA256_LEN) {
         ESP_LOGW(TAG, "Invalid X-Hotreload-SHA256 hex");
         send_403(req, "Invalid X-Hotreload-SHA256 value\n");
         return ESP_FAIL;
     }
-    if (hex_decode(hmac_hex, 64, expected_hmac, sizeof(expected_hmac)) != HOTRELOAD_HMAC_LEN) {
+    if (hex_decode(hmac_hex, 64, expected_hmac, HOTRELOAD_HMAC_LEN) != HOTRELOAD_HMAC_LEN) {
         ESP_LOGW(TAG, "Invalid X-Hotreload-HMAC hex");
         send_403(req, "Invalid X-Hotreload-HMAC value\n");
         return ESP_FAIL;
     }
 
-    // Step 1: SHA-256 integrity check (fast reject of corrupted uploads)
-    esp_err_t err = hotreload_crypto_sha256_verify(body, body_len, expected_sha256);
-    if (err != ESP_OK) {
+    return ESP_OK;
+}
+
+// Check the digests accumulated while receiving against the upload headers
+static esp_err_t verify_upload_hmac(httpd_req_t *req, hotreload_crypto_verify_ctx_t *verify,
+                                    const uint8_t *expected_sha256, const uint8_t *expected_hmac)
+{
+    // SHA-256 is checked first, for a fast reject of corrupted uploads
+    esp_err_t err = hotreload_crypto_verify_finish(verify, expected_sha256, expected_hmac);
+    if (err == ESP_ERR_INVALID_STATE) {
         send_403(req, "SHA-256 integrity check failed\n");
         return ESP_FAIL;
     }
-
-    // Step 2: HMAC-SHA256 authentication
-    err = hotreload_crypto_hmac_verify(body, body_len, expected_hmac);
     if (err != ESP_OK) {
         send_403(req, "HMAC authentication failed\n");
         return ESP_FAIL;
@@ -131,15 +136,31 @@ static esp_err_t upload_post_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    // Allocate buffer for upload
+    // Reject unauthenticated requests before receiving the body
+    uint8_t expected_sha256[HOTRELOAD_SHA256_LEN];
+    uint8_t expected_hmac[HOTRELOAD_HMAC_LEN];
+    if (read_upload_digests(req, expected_sha256, expected_hmac) != ESP_OK) {
+        return ESP_FAIL;  // Response already sent by read_upload_digests
+    }
+
+    hotreload_crypto_verify_ctx_t *verify;
+    esp_err_t err = hotreload_crypto_verify_start(&verify);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Crypto init failed");
+        return ESP_FAIL;
+    }
+
+    // Allocate buffer for upload. It is written to flash only once verified,
+    // so a rejected upload leaves the partition untouched.
     s_upload_buffer = malloc(req->content_len);
     if (s_upload_buffer == NULL) {
         ESP_LOGE(TAG, "Failed to allocate %d bytes for upload", req->content_len);
+        hotreload_crypto_verify_abort(verify);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         return ESP_FAIL;
     }
 
-    // Receive the file
+    // Receive the file, hashing each chunk as it arrives
     size_t received = 0;
     while (received < (size_t)req->content_len) {
         int ret = httpd_req_recv(req, (char *)(s_upload_buffer + received),
@@ -149,11 +170,19 @@ static esp_err_t upload_post_handler(httpd_req_t *req)
                 continue;  // Retry on timeout
             }
             ESP_LOGE(TAG, "Receive error: %d", ret);
+            hotreload_crypto_verify_abort(verify);
             free(s_upload_buffer);
             s_upload_buffer = NULL;
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Receive failed");
             return ESP_FAIL;
         }
+        if (hotreload_crypto_verify_update(verify, s_upload_buffer + received, ret) != ESP_OK) {
+            hotreload_crypto_verify_abort(verify);
+            free(s_upload_buffer);
+            s_upload_buffer = NULL;
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Hashing failed");
+            return ESP_FAIL;
+        }
         received += ret;
     }
 
@@ -161,7 +190,7 @@ static esp_err_t upload_post_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "Received %d bytes", (int)s_upload_size);
 
     // Verify HMAC before writing to flash
-    esp_err_t err = verify_upload_hmac(req, s_upload_buffer, s_upload_size);
+    err = verify_upload_hmac(req, verify, expected_sha256, expected_hmac);
     if (err != ESP_OK) {
         free(s_upload_buffer);
         s_upload_buffer = NULL;
@@ -208,6 +237,179 @@ static esp_err_t pending_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// GET /benchmark handler - result of the last benchmark comparison
+static esp_err_t benchmark_get_handler(httpd_req_t *req)
+{
+    static const char *const verdicts[] = {
+        [HOTRELOAD_BENCHMARK_NONE] = "none",
+        [HOTRELOAD_BENCHMARK_SKIPPED] = "skipped",
+        [HOTRELOAD_BENCHMARK_KEPT] = "kept",
+        [HOTRELOAD_BENCHMARK_ROLLED_BACK] = "rolled_back",
+    };
+
+    hotreload_stats_t stats;
+    hotreload_get_stats(&stats);
+    const hotreload_benchmark_result_t *res = &stats.benchmark;
+
+    char json[160];
+    snprintf(json, sizeof(json),
+             "{\"seq\":%" PRIu32 ",\"verdict\":\"%s\",\"old_cycles\":%" PRIu32
+             ",\"new_cycles\":%" PRIu32 ",\"threshold_pct\":%" PRId32 "}\n",
+             res->seq, verdicts[res->verdict], res->old_cycles, res->new_cycles, res->threshold_pct);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, json);
+    return ESP_OK;
+}
+
+#if CONFIG_HOTRELOAD_INVOKE_ENDPOINT
+extern const char *const hotreload_symbol_names[];
+extern const size_t hotreload_symbol_count;
+
+#define INVOKE_MAX_BODY     256
+#define INVOKE_MAX_REPEAT   100000
+
+// Parse a comma-separated list of integers (decimal, 0x hex, or negative)
+static int parse_invoke_args(char *list, uint32_t *args)
+{
+    int n = 0;
+    char *save;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        if (n == HOTRELOAD_INVOKE_MAX_ARGS) {
+            return -1;
+        }
+        char *end;
+        args[n++] = (tok[0] == '-') ? (uint32_t)strtol(tok, &end, 0) : (uint32_t)strtoul(tok, &end, 0);
+        if (end == tok || *end != '\0') {
+            return -1;
+        }
+    }
+    return n;
+}
+
+// POST /invoke handler - call an exported function and time it.
+// Body: name=<function> or index=<n>, optional args=<a>,<b>,... and repeat=<n>,
+// authenticated with the same headers as /upload.
+static esp_err_t invoke_post_handler(httpd_req_t *req)
+{
+    if (req->content_len == 0 || req->content_len >= INVOKE_MAX_BODY) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid request size");
+        return ESP_FAIL;
+    }
+
+    uint8_t expected_sha256[HOTRELOAD_SHA256_LEN];
+    uint8_t expected_hmac[HOTRELOAD_HMAC_LEN];
+    if (read_upload_digests(req, expected_sha256, expected_hmac) != ESP_OK) {
+        return ESP_FAIL;  // Response already sent by read_upload_digests
+    }
+
+    char body[INVOKE_MAX_BODY];
+    size_t received = 0;
+    while (received < (size_t)req->content_len) {
+        int ret = httpd_req_recv(req, body + received, req->content_len - received);
+        if (ret <= 0) {
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;  // Retry on timeout
+            }
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Receive failed");
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    body[received] = '\0';
+
+    hotreload_crypto_verify_ctx_t *verify;
+    if (hotreload_crypto_verify_start(&verify) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Crypto init failed");
+        return ESP_FAIL;
+    }
+    if (hotreload_crypto_verify_update(verify, (const uint8_t *)body, received) != ESP_OK) {
+        hotreload_crypto_verify_abort(verify);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Hashing failed");
+        return ESP_FAIL;
+    }
+    if (verify_upload_hmac(req, verify, expected_sha256, expected_hmac) != ESP_OK) {
+        return ESP_FAIL;  // Response already sent by verify_upload_hmac
+    }
+
+    // Function by name or by index into the symbol table
+    char value[128];
+    size_t index = hotreload_symbol_count;
+    if (httpd_query_key_value(body, "name", value, sizeof(value)) == ESP_OK) {
+        for (size_t i = 0; i < hotreload_symbol_count; i++) {
+            if (strcmp(hotreload_symbol_names[i], value) == 0) {
+                index = i;
+                break;
+            }
+        }
+    } else if (httpd_query_key_value(body, "index", value, sizeof(value)) == ESP_OK) {
+        char *end;
+        index = strtoul(value, &end, 10);
+        if (end == value || *end != '\0') {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid index");
+            return ESP_FAIL;
+        }
+    } else {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing name or index");
+        return ESP_FAIL;
+    }
+
+    uint32_t args[HOTRELOAD_INVOKE_MAX_ARGS];
+    int nargs = 0;
+    if (httpd_query_key_value(body, "args", value, sizeof(value)) == ESP_OK) {
+        nargs = parse_invoke_args(value, args);
+        if (nargs < 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid args");
+            return ESP_FAIL;
+        }
+    }
+
+    uint32_t repeat = 1;
+    if (httpd_query_key_value(body, "repeat", value, sizeof(value)) == ESP_OK) {
+        char *end;
+        repeat = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || repeat == 0 || repeat > INVOKE_MAX_REPEAT) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid repeat count");
+            return ESP_FAIL;
+        }
+    }
+
+    hotreload_invoke_result_t res;
+    esp_err_t err = hotreload_invoke(index, args, nargs, repeat, &res);
+    if (err == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such exported function");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        const char *reason = err == ESP_ERR_INVALID_ARG ? "Argument count does not match the signature" :
+                             err == ESP_ERR_NOT_SUPPORTED ? "Signature unknown or not supported" :
+                             "Module not loaded";
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, reason);
+        return ESP_FAIL;
+    }
+
+    char result[24];
+    if (res.ret_type == HOTRELOAD_INVOKE_RET_VOID) {
+        strcpy(result, "null");
+    } else if (res.ret_type == HOTRELOAD_INVOKE_RET_INT) {
+        snprintf(result, sizeof(result), "%" PRId32, (int32_t)res.result);
+    } else {
+        snprintf(result, sizeof(result), "%" PRIu32, res.result);
+    }
+
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"index\":%u,\"name\":\"%s\",\"result\":%s,\"calls\":%" PRIu32
+             ",\"min_cycles\":%" PRIu32 ",\"mean_cycles\":%" PRIu32 ",\"max_cycles\":%" PRIu32 "}\n",
+             (unsigned)index, hotreload_symbol_names[index], result, res.calls,
+             res.min_cycles, res.mean_cycles, res.max_cycles);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, json);
+    return ESP_OK;
+}
+#endif // CONFIG_HOTRELOAD_INVOKE_ENDPOINT
+
 // GET /status handler - returns server status
 static esp_err_t status_get_handler(httpd_req_t *req)
 {
@@ -278,9 +480,25 @@ esp_err_t hotreload_server_start(const hotreload_server_config_t *config)
         .handler = status_get_handler,
     };
 
+    static const httpd_uri_t benchmark_uri = {
+        .uri = "/benchmark",
+        .method = HTTP_GET,
+        .handler = benchmark_get_handler,
+    };
+
     httpd_register_uri_handler(s_server, &upload_uri);
     httpd_register_uri_handler(s_server, &pending_uri);
     httpd_register_uri_handler(s_server, &status_uri);
+    httpd_register_uri_handler(s_server, &benchmark_uri);
+
+#if CONFIG_HOTRELOAD_INVOKE_ENDPOINT
+    static const httpd_uri_t invoke_uri = {
+        .uri = "/invoke",
+        .method = HTTP_POST,
+        .handler = invoke_post_handler,
+    };
+    httpd_register_uri_handler(s_server, &invoke_uri);
+#endif
 
     // Get and display the server URL with IP address
     esp_netif_t *netif = esp_netif_get_default_netif();
@@ -298,6 +516,10 @@ esp_err_t hotreload_server_start(const hotreload_server_config_t *config)
     ESP_LOGI(TAG, "  POST /upload  - Upload ELF to flash");
     ESP_LOGI(TAG, "  GET  /pending - Check if update is pending");
     ESP_LOGI(TAG, "  GET  /status  - Server status");
+    ESP_LOGI(TAG, "  GET  /benchmark - Last benchmark comparison");
+#if CONFIG_HOTRELOAD_INVOKE_ENDPOINT
+    ESP_LOGI(TAG, "  POST /invoke  - Call an exported function");
+#endif
 
     return ESP_OK;
 }
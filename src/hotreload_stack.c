@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file hotreload_stack.c
+ * @brief Stack high-water tracking for calls into the reloadable module
+ *
+ * With CONFIG_HOTRELOAD_STACK_TRACKING, the generated stubs call
+ * hotreload_stack_probe_enter() before jumping into the module and
+ * hotreload_stack_probe_exit() after it returns. The enter probe paints the
+ * free stack below the call site, the exit probe finds the deepest word that
+ * was overwritten.
+ *
+ * Words still holding the FreeRTOS fill byte (never used by the task) are
+ * left alone, so uxTaskGetStackHighWaterMark() keeps reporting the same
+ * value it would without tracking.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "hotreload.h"
+#include "hotreload_stack.h"
+
+#if CONFIG_HOTRELOAD_STACK_TRACKING
+
+static const char *TAG = "hotreload_stack";
+
+// Symbol table - defined by the reloadable component
+extern const char *const hotreload_symbol_names[];
+extern const size_t hotreload_symbol_count;
+
+#define FILL_WORD       0xa5a5a5a5u     // FreeRTOS tskSTACK_FILL_BYTE, never-used stack
+#define PAINT_WORD      0xcecececeu     // Used stack repainted by the enter probe
+
+// Room left below the probe's own stack pointer for the calls it makes
+// before painting (enter) or scanning (exit)
+#define PROBE_GUARD     128
+
+// Kept clear at the end of the task stack, where the stack overflow
+// canary and the end-of-stack watchpoint live
+#define STACK_END_GUARD 64
+
+static hotreload_stack_usage_t *s_usage;
+static portMUX_TYPE s_usage_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Stack range the probes work on for a call from caller_sp.
+// Returns false if the call is not measured.
+static bool probe_range(uintptr_t caller_sp, uint32_t **bottom, uint32_t **top)
+{
+    if (s_usage == NULL || xPortInIsrContext() ||
+            xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return false;
+    }
+
+    uintptr_t stack_start = (uintptr_t)pxTaskGetStackStart(NULL) + STACK_END_GUARD;
+    uintptr_t lo = caller_sp - CONFIG_HOTRELOAD_STACK_TRACKING_WINDOW;
+    uintptr_t hi = (uintptr_t)esp_cpu_get_sp() - PROBE_GUARD;
+
+    if (lo < stack_start || lo > caller_sp) {
+        lo = stack_start;
+    }
+    lo = (lo + 3) & ~(uintptr_t)3;
+    hi &= ~(uintptr_t)3;
+    if (hi <= lo) {
+        return false;
+    }
+
+    *bottom = (uint32_t *)lo;
+    *top = (uint32_t *)hi;
+    return true;
+}
+
+void hotreload_stack_probe_enter(uint32_t index, uintptr_t caller_sp)
+{
+    uint32_t *bottom, *top;
+    if (index >= hotreload_symbol_count || !probe_range(caller_sp, &bottom, &top)) {
+        return;
+    }
+
+    // volatile keeps the compiler from turning this into a memset() call,
+    // which would put a stack frame into the range being painted
+    for (volatile uint32_t *p = bottom; p < top; p++) {
+        if (*p != FILL_WORD) {
+            *p = PAINT_WORD;
+        }
+    }
+}
+
+void hotreload_stack_probe_exit(uint32_t index, uintptr_t caller_sp)
+{
+    uint32_t *bottom, *top;
+    if (index >= hotreload_symbol_count || !probe_range(caller_sp, &bottom, &top)) {
+        return;
+    }
+
+    volatile uint32_t *p = bottom;
+    while (p < top && (*p == FILL_WORD || *p == PAINT_WORD)) {
+        p++;
+    }
+
+    uint32_t depth = caller_sp - (uintptr_t)p;
+    bool overflowed = (p == bottom);
+
+    portENTER_CRITICAL_SAFE(&s_usage_lock);
+    hotreload_stack_usage_t *u = &s_usage[index];
+    if (depth > u->max_depth) {
+        u->max_depth = depth;
+    }
+    u->overflowed |= overflowed;
+    u->calls++;
+    portEXIT_CRITICAL_SAFE(&s_usage_lock);
+}
+
+void hotreload_stack_reset(void)
+{
+    if (s_usage == NULL) {
+        hotreload_stack_usage_t *usage = calloc(hotreload_symbol_count, sizeof(*usage));
+        if (usage == NULL) {
+            ESP_LOGW(TAG, "No memory for stack tracking, disabled");
+            return;
+        }
+        s_usage = usage;
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&s_usage_lock);
+    memset(s_usage, 0, hotreload_symbol_count * sizeof(*s_usage));
+    portEXIT_CRITICAL_SAFE(&s_usage_lock);
+}
+
+esp_err_t hotreload_get_stack_usage(size_t index, const char **name, hotreload_stack_usage_t *usage)
+{
+    if (usage == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (index >= hotreload_symbol_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_usage == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (name) {
+        *name = hotreload_symbol_names[index];
+    }
+    portENTER_CRITICAL_SAFE(&s_usage_lock);
+    *usage = s_usage[index];
+    portEXIT_CRITICAL_SAFE(&s_usage_lock);
+    return ESP_OK;
+}
+
+#else // CONFIG_HOTRELOAD_STACK_TRACKING
+
+void hotreload_stack_reset(void)
+{
+}
+
+esp_err_t hotreload_get_stack_usage(size_t index, const char **name, hotreload_stack_usage_t *usage)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_HOTRELOAD_STACK_TRACKING
@@ -7,6 +7,13 @@ extern "C" {
 void reloadable_init(void);
 void reloadable_hello(const char *name);
 
+/**
+ * @brief Interrupt handler used by the hotreload_intr_alloc() tests.
+ *
+ * Increments the int pointed to by arg.
+ */
+void reloadable_isr(void *arg);
+
 /**
  * @brief Returns a value from a compile definition set via INTERFACE property.
  *
@@ -16,6 +23,14 @@ void reloadable_hello(const char *name);
  */
 int reloadable_get_compile_def_value(void);
 
+/**
+ * @brief Calls fn(arg) from inside the module.
+ *
+ * Used by the hotreload_reload_when_safe() tests to keep a task inside
+ * reloadable code while fn blocks.
+ */
+void reloadable_call(void (*fn)(void *), void *arg);
+
 #ifdef __cplusplus
 }
 #endif
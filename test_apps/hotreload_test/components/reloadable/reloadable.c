@@ -1,17 +1,47 @@
 #include "esp_system.h"
 #include <string.h>
+#include <stdint.h>
 
 static int reloadable_hello_count;
 static const char *reloadable_greeting = "Hello";
 
+int reloadable_initial_count(void);  // reloadable_shadow.c
+
 void reloadable_init(void)
 {
-    reloadable_hello_count = 0;
+    reloadable_hello_count = reloadable_initial_count();
+}
+
+/* Global but not declared in reloadable.h: not exported, so it gets no
+ * stub in the main program. */
+int reloadable_next_count(void)
+{
+    return reloadable_hello_count++;
 }
 
 void reloadable_hello(const char *name)
 {
-    printf("%s, %s, from %s! %d\n", reloadable_greeting, name, esp_get_idf_version(), reloadable_hello_count++);
+    printf("%s, %s, from %s! %d\n", reloadable_greeting, name, esp_get_idf_version(), reloadable_next_count());
+}
+
+void reloadable_isr(void *arg)
+{
+    (*(volatile int *)arg)++;
+}
+
+void reloadable_call(void (*fn)(void *), void *arg)
+{
+    fn(arg);
+}
+
+/* Benchmark entry point, run before a reload is committed when
+ * CONFIG_HOTRELOAD_BENCHMARK_GATE is enabled. */
+void hotreload_benchmark(void)
+{
+    volatile uint32_t acc = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        acc += i * i;
+    }
 }
 
 int reloadable_get_compile_def_value(void)
@@ -0,0 +1,15 @@
+#include <stdint.h>
+
+/* A file-static with the same name as the export in reloadable.c. The loader
+ * must bind the export, which returns 42, and never this one. */
+static __attribute__((noinline)) int reloadable_get_compile_def_value(void)
+{
+    return 0;
+}
+
+/* Not exported. Called by reloadable_init(), so that the static above is not
+ * garbage collected. */
+int reloadable_initial_count(void)
+{
+    return reloadable_get_compile_def_value();
+}
@@ -12,6 +12,19 @@ import pytest
 DEVICE_PORT = 8080  # Port the device listens on inside QEMU
 
 
+def pytest_addoption(parser):
+    """Options for the loader benchmark (test_loader_phase_instructions)."""
+    group = parser.getgroup("hotreload")
+    group.addoption("--loader-benchmark", action="store_true", default=False,
+                    help="Count the instructions of each loader phase in QEMU with -icount")
+    group.addoption("--loader-baseline", default=None,
+                    help="JSON file with per-target instruction counts to compare against")
+    group.addoption("--loader-save-baseline", default=None,
+                    help="JSON file to store the measured instruction counts in")
+    group.addoption("--loader-tolerance", type=float, default=0.0,
+                    help="Allowed increase over the baseline, in percent (default: 0)")
+
+
 def pytest_configure(config):
     """Register custom markers."""
     config.addinivalue_line("markers", "qemu: mark test as QEMU-only")
@@ -1,4 +1,6 @@
 #include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
 #include "unity.h"
 #include "unity_test_runner.h"
 #include "elf_parser.h"
@@ -7,6 +9,15 @@
 #include "esp_partition.h"
 #include "reloadable.h"
 #include "soc/soc.h"  // For SOC_I_D_OFFSET on RISC-V targets
+#include "soc/interrupts.h"
+#include "esp_intr_alloc.h"
+#include "esp_cpu.h"
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "xtensa_api.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 // Symbol table externs for test access
 extern uint32_t hotreload_symbol_table[];
@@ -1152,7 +1163,8 @@ TEST_CASE("compile definitions are propagated to reloadable component", "[elf_lo
     err = elf_loader_sync_cache(&ctx);
     TEST_ASSERT_EQUAL(ESP_OK, err);
 
-    // Get the function that returns the compile definition value
+    // Get the function that returns the compile definition value.
+    // reloadable_shadow.c defines a file-static of the same name returning 0.
     typedef int (*get_def_fn_t)(void);
     get_def_fn_t get_def_fn = (get_def_fn_t)elf_loader_get_symbol(&ctx, "reloadable_get_compile_def_value");
     TEST_ASSERT_NOT_NULL_MESSAGE(get_def_fn, "reloadable_get_compile_def_value not found");
@@ -1167,6 +1179,150 @@ TEST_CASE("compile definitions are propagated to reloadable component", "[elf_lo
     esp_partition_munmap(mmap_handle);
 }
 
+// ============================================================================
+// Section reuse tests - elf_loader_reuse() and .hotreload_ro_digest
+// ============================================================================
+
+TEST_CASE("elf_loader_reuse keeps the read-only sections of the previous load", "[elf_loader][reuse]")
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, "hotreload");
+    TEST_ASSERT_NOT_NULL(partition);
+
+    esp_partition_mmap_handle_t mmap_handle;
+    const void *mmap_ptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size,
+                                       ESP_PARTITION_MMAP_DATA, &mmap_ptr, &mmap_handle);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+
+    // Previous image, fully loaded
+    elf_loader_ctx_t prev;
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_init(&prev, mmap_ptr, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_calculate_memory_layout(&prev, NULL, NULL));
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, prev.ro_range_count, "No .hotreload_ro_digest section in the ELF");
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_allocate(&prev));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_load_sections(&prev));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_apply_relocations(&prev));
+    void *text_base = prev.text_base;
+    void *data_base = prev.data_base;
+
+    // Same ELF again: every read-only section is kept
+    elf_loader_ctx_t ctx;
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_init(&ctx, mmap_ptr, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_calculate_memory_layout(&ctx, NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_reuse(&ctx, &prev));
+
+    size_t ro_bytes = 0;
+    for (size_t i = 0; i < ctx.ro_range_count; i++) {
+        ro_bytes += ctx.ro_ranges[i].hi - ctx.ro_ranges[i].lo;
+        TEST_ASSERT_TRUE(elf_port_vma_reused(&ctx.mem_ctx, ctx.ro_ranges[i].lo));
+    }
+    TEST_ASSERT_EQUAL(ro_bytes, ctx.reused_size);
+    TEST_ASSERT_EQUAL_PTR(text_base, ctx.text_base);
+    TEST_ASSERT_EQUAL_PTR(data_base, ctx.data_base);
+    TEST_ASSERT_NULL(prev.text_base);
+    TEST_ASSERT_NULL(prev.ram_base);
+    elf_loader_cleanup(&prev);
+
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_load_sections(&ctx));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_apply_relocations(&ctx));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_sync_cache(&ctx));
+
+    // Kept code is still correctly relocated
+    typedef int (*get_def_fn_t)(void);
+    get_def_fn_t get_def_fn = (get_def_fn_t)elf_loader_get_symbol(&ctx, "reloadable_get_compile_def_value");
+    TEST_ASSERT_NOT_NULL(get_def_fn);
+    TEST_ASSERT_EQUAL(42, get_def_fn());
+
+    elf_loader_cleanup(&ctx);
+    esp_partition_munmap(mmap_handle);
+}
+
+TEST_CASE("elf_loader_reuse rejects a changed read-only part", "[elf_loader][reuse]")
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, "hotreload");
+    TEST_ASSERT_NOT_NULL(partition);
+
+    esp_partition_mmap_handle_t mmap_handle;
+    const void *mmap_ptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size,
+                                       ESP_PARTITION_MMAP_DATA, &mmap_ptr, &mmap_handle);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+
+    elf_loader_ctx_t prev;
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_init(&prev, mmap_ptr, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_calculate_memory_layout(&prev, NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_allocate(&prev));
+    void *text_base = prev.text_base;
+
+    // Same layout, but as if code or a constant had changed
+    elf_loader_ctx_t ctx;
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_init(&ctx, mmap_ptr, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_calculate_memory_layout(&ctx, NULL, NULL));
+    ctx.ro_digest[0] ^= 0xff;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, elf_loader_reuse(&ctx, &prev));
+
+    // Nothing was taken over
+    TEST_ASSERT_EQUAL_PTR(text_base, prev.text_base);
+    TEST_ASSERT_NULL(ctx.text_base);
+    TEST_ASSERT_NULL(ctx.ram_base);
+    TEST_ASSERT_EQUAL(0, ctx.reused_size);
+
+    elf_loader_cleanup(&ctx);
+    elf_loader_cleanup(&prev);
+    esp_partition_munmap(mmap_handle);
+}
+
+TEST_CASE("elf_loader_reuse rejects a previous image without memory", "[elf_loader][reuse]")
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, "hotreload");
+    TEST_ASSERT_NOT_NULL(partition);
+
+    esp_partition_mmap_handle_t mmap_handle;
+    const void *mmap_ptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size,
+                                       ESP_PARTITION_MMAP_DATA, &mmap_ptr, &mmap_handle);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+
+    elf_loader_ctx_t ctx;
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_init(&ctx, mmap_ptr, partition->size));
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_calculate_memory_layout(&ctx, NULL, NULL));
+
+    elf_loader_ctx_t prev = {0};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, elf_loader_reuse(&ctx, &prev));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, elf_loader_reuse(&ctx, NULL));
+
+    // Nothing was taken over, a normal allocation still works
+    TEST_ASSERT_EQUAL(ESP_OK, elf_loader_allocate(&ctx));
+
+    elf_loader_cleanup(&ctx);
+    esp_partition_munmap(mmap_handle);
+}
+
+// The benchmark gate (the module exports hotreload_benchmark) keeps the old
+// image live during the load, so there is nothing to take over
+#if !CONFIG_HOTRELOAD_BENCHMARK_GATE
+TEST_CASE("hotreload_reload keeps the read-only sections of an unchanged image", "[hotreload][reuse]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&stats));
+    TEST_ASSERT_EQUAL(0, stats.reused_size);
+
+    // Same partition contents: the read-only sections stay in place
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&stats));
+    TEST_ASSERT_GREATER_THAN(0, stats.reused_size);
+    TEST_ASSERT_EQUAL(42, reloadable_get_compile_def_value());
+
+    hotreload_unload();
+}
+#endif // !CONFIG_HOTRELOAD_BENCHMARK_GATE
+
 // ============================================================================
 // High-level API tests - hotreload_load()
 // ============================================================================
@@ -1249,6 +1405,808 @@ TEST_CASE("reloadable functions can be called through stubs", "[hotreload][stubs
     hotreload_unload();
 }
 
+// ============================================================================
+// Deadline-aware reload tests - hotreload_reload_within()
+// ============================================================================
+
+TEST_CASE("hotreload_get_stats records every load phase", "[hotreload][commit]")
+{
+    hotreload_stats_t before;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_stats_t after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.load_count + 1, after.load_count);
+    TEST_ASSERT_GREATER_THAN(0, after.image_size);
+    for (int i = 0; i < HOTRELOAD_PHASE_MAX; i++) {
+        TEST_ASSERT_EQUAL(before.phase[i].runs + 1, after.phase[i].runs);
+        TEST_ASSERT_GREATER_OR_EQUAL(after.phase[i].last_us, after.phase[i].max_us);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_get_stats(NULL));
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_within defers when budget is zero", "[hotreload][commit]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+    uint32_t table_before = hotreload_symbol_table[0];
+
+    hotreload_commit_result_t res;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_within(&config, 0, &res));
+    TEST_ASSERT_EQUAL(HOTRELOAD_COMMIT_DEFERRED, res.status);
+    TEST_ASSERT_EQUAL(HOTRELOAD_DEFER_OVER_BUDGET, res.reason);
+    TEST_ASSERT_EQUAL(HOTRELOAD_PHASE_PARSE, res.next_phase);
+    TEST_ASSERT_GREATER_THAN(0, res.predicted_us);
+    TEST_ASSERT_TRUE(hotreload_reload_in_progress());
+
+    // Old code must still be live
+    TEST_ASSERT_EQUAL_HEX32(table_before, hotreload_symbol_table[0]);
+    reloadable_hello("Deferred");
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_abort());
+    TEST_ASSERT_FALSE(hotreload_reload_in_progress());
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, hotreload_reload_abort());
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_within completes within a per-phase budget", "[hotreload][commit]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    // Budget just large enough for the slowest phase, so the reload has to be split
+    hotreload_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&stats));
+    uint32_t budget_us = 0;
+    for (int i = 0; i < HOTRELOAD_PHASE_MAX; i++) {
+        if (stats.phase[i].max_us > budget_us) {
+            budget_us = stats.phase[i].max_us;
+        }
+    }
+    budget_us = budget_us * 2 + 100;
+
+    hotreload_commit_result_t res;
+    int calls = 0;
+    do {
+        TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_within(&config, budget_us, &res));
+        TEST_ASSERT_NOT_EQUAL(HOTRELOAD_DEFER_NO_HISTORY, res.reason);
+        // Stubs keep working between steps
+        reloadable_hello("Staged");
+        calls++;
+    } while (res.status != HOTRELOAD_COMMIT_DONE && calls < 2 * HOTRELOAD_PHASE_MAX);
+
+    TEST_ASSERT_EQUAL(HOTRELOAD_COMMIT_DONE, res.status);
+    TEST_ASSERT_EQUAL(HOTRELOAD_PHASE_MAX, res.next_phase);
+    TEST_ASSERT_FALSE(hotreload_reload_in_progress());
+
+    reloadable_init();
+    reloadable_hello("Committed");
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_within with large budget commits in one call", "[hotreload][commit]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_commit_result_t res;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_within(&config, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL(HOTRELOAD_COMMIT_DONE, res.status);
+    TEST_ASSERT_EQUAL(HOTRELOAD_DEFER_NONE, res.reason);
+
+    reloadable_init();
+    reloadable_hello("One call");
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_within rejects invalid arguments", "[hotreload][commit]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    hotreload_commit_result_t res;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_reload_within(NULL, 1000, &res));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_reload_within(&config, 1000, NULL));
+}
+
+// ============================================================================
+// Reloadable interrupt handler tests - hotreload_intr_alloc()
+// ============================================================================
+
+// The I2C peripheral is not clocked in these tests, so the source never fires;
+// the interrupt is also allocated disabled. The tests check the bookkeeping.
+#define TEST_INTR_SOURCE ETS_I2C_EXT0_INTR_SOURCE
+#define TEST_INTR_FLAGS (ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_INTRDISABLED)
+
+static volatile int s_test_isr_count;
+
+TEST_CASE("hotreload_intr_alloc rejects unknown handler", "[hotreload][intr]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_intr_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, hotreload_intr_alloc(TEST_INTR_SOURCE, TEST_INTR_FLAGS,
+                      "no_such_function", NULL, &handle));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_intr_alloc(TEST_INTR_SOURCE, TEST_INTR_FLAGS,
+                      NULL, NULL, &handle));
+    // The vector entry of a shared interrupt belongs to esp_intr_alloc()
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, hotreload_intr_alloc(TEST_INTR_SOURCE,
+                      TEST_INTR_FLAGS | ESP_INTR_FLAG_SHARED, "reloadable_isr", NULL, &handle));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_intr_free(NULL));
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_intr_alloc requires a loaded module", "[hotreload][intr]")
+{
+    hotreload_unload();
+
+    hotreload_intr_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, hotreload_intr_alloc(TEST_INTR_SOURCE, TEST_INTR_FLAGS,
+                      "reloadable_isr", (void *)&s_test_isr_count, &handle));
+}
+
+TEST_CASE("hotreload_intr_alloc handler survives reload and unload", "[hotreload][intr]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_intr_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_alloc(TEST_INTR_SOURCE, TEST_INTR_FLAGS,
+                      "reloadable_isr", (void *)&s_test_isr_count, &handle));
+
+    // Kept across reloads, the vector entry is rewritten with the new handler
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+    hotreload_commit_result_t res;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_within(&config, UINT32_MAX, &res));
+    TEST_ASSERT_EQUAL(HOTRELOAD_COMMIT_DONE, res.status);
+
+    // Disabled on unload, enabled again on load
+    hotreload_unload();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_free(handle));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_intr_free(handle));
+    TEST_ASSERT_EQUAL(0, s_test_isr_count);
+
+    hotreload_unload();
+}
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+
+// Internal software interrupt 0 is CPU interrupt 7. The test task triggers it
+// on its own core; the interrupt dispatcher clears it before the handler runs.
+#define TEST_SW_INTR_NUM 7
+
+static void trigger_sw_intr(void)
+{
+    xt_set_intset(1 << TEST_SW_INTR_NUM);
+    vTaskDelay(1);
+    xt_set_intclear(1 << TEST_SW_INTR_NUM);  // Still pending if disabled
+}
+
+TEST_CASE("hotreload_intr_alloc calls the new handler after reload", "[hotreload][intr]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    volatile int count = 0;
+    hotreload_intr_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_alloc(ETS_INTERNAL_SW0_INTR_SOURCE, ESP_INTR_FLAG_LEVEL1,
+                      "reloadable_isr", (void *)&count, &handle));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(1, count);
+
+    // Rebound to the new image's handler on commit
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(2, count);
+
+    // Disabled while unloaded, enabled again by the next load
+    hotreload_unload();
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(3, count);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_free(handle));
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_intr_alloc keeps a disabled interrupt disabled across reloads", "[hotreload][intr]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    volatile int count = 0;
+    hotreload_intr_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_alloc(ETS_INTERNAL_SW0_INTR_SOURCE,
+                      ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_INTRDISABLED,
+                      "reloadable_isr", (void *)&count, &handle));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(0, count);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_enable(handle));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(1, count);
+
+    // Disabled by the application, so the next load leaves it disabled
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_disable(handle));
+    hotreload_unload();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+    trigger_sw_intr();
+    TEST_ASSERT_EQUAL(1, count);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_intr_free(handle));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_intr_enable(handle));
+    hotreload_unload();
+}
+
+#endif // CONFIG_IDF_TARGET_ARCH_XTENSA
+
+// ============================================================================
+// Benchmark gate tests - CONFIG_HOTRELOAD_BENCHMARK_GATE
+// ============================================================================
+
+#if CONFIG_HOTRELOAD_BENCHMARK_GATE
+
+TEST_CASE("benchmark gate is skipped on first load", "[hotreload][benchmark_gate]")
+{
+    hotreload_unload();
+
+    hotreload_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.benchmark.seq + 1, after.benchmark.seq);
+    TEST_ASSERT_EQUAL(HOTRELOAD_BENCHMARK_SKIPPED, after.benchmark.verdict);
+
+    hotreload_unload();
+}
+
+TEST_CASE("benchmark gate keeps reloaded code within threshold", "[hotreload][benchmark_gate]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+
+    // Same image again: both runs should be within the configured threshold
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.benchmark.seq + 1, after.benchmark.seq);
+    TEST_ASSERT_EQUAL(HOTRELOAD_BENCHMARK_KEPT, after.benchmark.verdict);
+    TEST_ASSERT_GREATER_THAN(0, after.benchmark.old_cycles);
+    TEST_ASSERT_GREATER_THAN(0, after.benchmark.new_cycles);
+    TEST_ASSERT_EQUAL(CONFIG_HOTRELOAD_BENCHMARK_THRESHOLD, after.benchmark.threshold_pct);
+    TEST_ASSERT_EQUAL(before.load_count + 1, after.load_count);
+
+    reloadable_hello("Benchmarked");
+
+    hotreload_unload();
+}
+
+#endif // CONFIG_HOTRELOAD_BENCHMARK_GATE
+
+// ============================================================================
+// Loader phase benchmark - run by test_loader_phase_instructions in QEMU with -icount
+// ============================================================================
+
+#define LOADER_BENCH_RUNS 5
+
+// Cycle counter delta across a fixed block of 0 or 1000 instructions, which
+// gives test_hotreload.py the counter rate per instruction
+static uint32_t calibration_cycles_0(void)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    return esp_cpu_get_cycle_count() - start;
+}
+
+static uint32_t calibration_cycles_1000(void)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    __asm__ volatile(".rept 1000\n nop\n .endr");
+    return esp_cpu_get_cycle_count() - start;
+}
+
+TEST_CASE("loader phase instruction counts", "[hotreload][icount]")
+{
+    static const char *const phase_names[HOTRELOAD_PHASE_MAX] = {
+        "parse", "alloc", "load", "relocate", "sync_cache", "resolve", "benchmark", "commit",
+    };
+    uint32_t best[HOTRELOAD_PHASE_MAX];
+    for (int p = 0; p < HOTRELOAD_PHASE_MAX; p++) {
+        best[p] = UINT32_MAX;
+    }
+
+    // Fresh load every run (no old image, so the benchmark gate is skipped).
+    // The fastest run of each phase filters out tick interrupts, for phases
+    // shorter than a tick period (31250 instructions at shift=5).
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    for (int run = 0; run < LOADER_BENCH_RUNS; run++) {
+        hotreload_unload();
+        TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+        hotreload_stats_t stats;
+        TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&stats));
+        for (int p = 0; p < HOTRELOAD_PHASE_MAX; p++) {
+            if (stats.phase[p].last_cycles < best[p]) {
+                best[p] = stats.phase[p].last_cycles;
+            }
+        }
+    }
+
+    // Parsed by test_hotreload.py, which converts the cycles to instructions.
+    // Keep the format in sync.
+    uint32_t cal_0 = calibration_cycles_0();
+    uint32_t cal_1000 = calibration_cycles_1000();
+    printf("LOADER_CALIBRATION %" PRIu32 " %" PRIu32 "\n", cal_0, cal_1000);
+    for (int p = 0; p < HOTRELOAD_PHASE_MAX; p++) {
+        printf("LOADER_PHASE_CYCLES %s %" PRIu32 "\n", phase_names[p], best[p]);
+    }
+    printf("LOADER_DONE\n");
+
+    hotreload_unload();
+}
+
+// ============================================================================
+// Export list tests - EXPORT_HEADERS / EXPORTS in the reloadable component
+// ============================================================================
+
+static bool symbol_table_has(const char *name)
+{
+    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+        if (strcmp(hotreload_symbol_names[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE("symbol table contains only exported functions", "[hotreload][exports]")
+{
+    // Declared in reloadable.h
+    TEST_ASSERT_TRUE(symbol_table_has("reloadable_init"));
+    TEST_ASSERT_TRUE(symbol_table_has("reloadable_hello"));
+    TEST_ASSERT_TRUE(symbol_table_has("reloadable_isr"));
+    TEST_ASSERT_TRUE(symbol_table_has("reloadable_get_compile_def_value"));
+    TEST_ASSERT_TRUE(symbol_table_has("reloadable_call"));
+    // Listed in EXPORTS
+    TEST_ASSERT_TRUE(symbol_table_has("hotreload_benchmark"));
+    // Global in reloadable.c, but not exported
+    TEST_ASSERT_FALSE(symbol_table_has("reloadable_next_count"));
+    TEST_ASSERT_EQUAL(6, hotreload_symbol_count);
+}
+
+TEST_CASE("unexported functions still work inside the module", "[hotreload][exports]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    // reloadable_hello() calls the hidden reloadable_next_count()
+    reloadable_init();
+    reloadable_hello("Exports");
+
+    hotreload_unload();
+}
+
+// ============================================================================
+// Priority export tests - PRIORITY_EXPORTS / CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+// ============================================================================
+
+extern const size_t hotreload_symbol_priority_count;
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+extern void (*const hotreload_symbol_pending[])(void);
+#endif
+
+TEST_CASE("priority exports take the first symbol table slots", "[hotreload][priority]")
+{
+    TEST_ASSERT_EQUAL(1, hotreload_symbol_priority_count);
+    TEST_ASSERT_EQUAL_STRING("reloadable_hello", hotreload_symbol_names[0]);
+}
+
+#if CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+
+TEST_CASE("priority exports are callable before the rest is published", "[hotreload][priority]")
+{
+    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+        hotreload_symbol_table[i] = 0;
+    }
+
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    // Published before hotreload_load() returned
+    TEST_ASSERT_NOT_EQUAL(0, hotreload_symbol_table[0]);
+    reloadable_hello("Priority");
+
+    // The others are callable too, and wait for the publish
+    reloadable_init();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_wait_published(0));
+    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(0, hotreload_symbol_table[i],
+            "Symbol table entry should be non-zero after background publish");
+        TEST_ASSERT_NOT_EQUAL_MESSAGE((uint32_t)(uintptr_t)hotreload_symbol_pending[i], hotreload_symbol_table[i],
+            "Symbol table entry should not be a pending stub after background publish");
+    }
+
+    hotreload_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&stats));
+    TEST_ASSERT_GREATER_THAN(0, stats.background_us);
+
+    hotreload_unload();
+}
+
+static void count_call(void *arg)
+{
+    (*(int *)arg)++;
+}
+
+TEST_CASE("exports not published yet wait for the background publish", "[hotreload][priority]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_wait_published(1000));
+
+    // Keep the background task from running before the calls below, at
+    // least on this core
+    UBaseType_t prio = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, CONFIG_HOTRELOAD_BACKGROUND_PUBLISH_TASK_PRIORITY + 1);
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+
+    // Never the previous image: its entries now hold pending stubs, which
+    // wait for the publish and then call the new image
+    uint32_t entry = hotreload_symbol_table[1];
+    TEST_ASSERT_TRUE(entry == (uint32_t)(uintptr_t)hotreload_symbol_pending[1] ||
+                hotreload_wait_published(0) == ESP_OK);
+    int calls = 0;
+    reloadable_call(count_call, &calls);
+    vTaskPrioritySet(NULL, prio);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_wait_published(0));
+    reloadable_hello("Reload");
+
+    // The next unload waits for the background task by itself
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_unload());
+}
+
+#endif // CONFIG_HOTRELOAD_BACKGROUND_PUBLISH
+
+// ============================================================================
+// Invoke tests - hotreload_invoke() and the generated signature manifest
+// ============================================================================
+
+static size_t symbol_index(const char *name)
+{
+    for (size_t i = 0; i < hotreload_symbol_count; i++) {
+        if (strcmp(hotreload_symbol_names[i], name) == 0) {
+            return i;
+        }
+    }
+    TEST_FAIL_MESSAGE("symbol not exported");
+    return 0;
+}
+
+TEST_CASE("invoke returns the result and cycle counts", "[hotreload][invoke]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_invoke_result_t res;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_invoke(symbol_index("reloadable_get_compile_def_value"),
+                                               NULL, 0, 10, &res));
+    TEST_ASSERT_EQUAL(HOTRELOAD_INVOKE_RET_INT, res.ret_type);
+    TEST_ASSERT_EQUAL(42, res.result);
+    TEST_ASSERT_EQUAL(10, res.calls);
+    TEST_ASSERT_GREATER_THAN(0, res.min_cycles);
+    TEST_ASSERT_LESS_OR_EQUAL(res.mean_cycles, res.min_cycles);
+    TEST_ASSERT_LESS_OR_EQUAL(res.max_cycles, res.mean_cycles);
+
+    hotreload_unload();
+}
+
+TEST_CASE("invoke passes pointer arguments", "[hotreload][invoke]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    // reloadable_isr() increments the int its argument points to
+    volatile int counter = 0;
+    uint32_t args[] = { (uint32_t)(uintptr_t)&counter };
+    hotreload_invoke_result_t res;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_invoke(symbol_index("reloadable_isr"), args, 1, 3, &res));
+    TEST_ASSERT_EQUAL(HOTRELOAD_INVOKE_RET_VOID, res.ret_type);
+    TEST_ASSERT_EQUAL(3, counter);
+
+    hotreload_unload();
+}
+
+TEST_CASE("invoke rejects calls that do not match the manifest", "[hotreload][invoke]")
+{
+    hotreload_invoke_result_t res;
+    uint32_t args[HOTRELOAD_INVOKE_MAX_ARGS] = {0};
+    size_t isr = symbol_index("reloadable_isr");
+
+    // Not loaded yet
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, hotreload_invoke(isr, args, 1, 1, &res));
+
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_invoke(isr, args, 2, 1, &res));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_invoke(isr, args, 1, 0, &res));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_invoke(isr, args, 1, 1, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, hotreload_invoke(hotreload_symbol_count, NULL, 0, 1, &res));
+    // Listed in EXPORTS only, so no prototype was parsed
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED,
+                      hotreload_invoke(symbol_index("hotreload_benchmark"), NULL, 0, 1, &res));
+
+    hotreload_unload();
+}
+
+typedef struct {
+    SemaphoreHandle_t entered;
+    SemaphoreHandle_t release;
+    SemaphoreHandle_t done;
+    esp_err_t err;
+} invoke_reload_ctx_t;
+
+// Called through hotreload_invoke() from inside the module
+static void invoke_test_wait(void *arg)
+{
+    invoke_reload_ctx_t *ctx = (invoke_reload_ctx_t *)arg;
+    xSemaphoreGive(ctx->entered);
+    xSemaphoreTake(ctx->release, portMAX_DELAY);
+}
+
+static void invoke_test_task(void *arg)
+{
+    invoke_reload_ctx_t *ctx = (invoke_reload_ctx_t *)arg;
+    uint32_t args[] = { (uint32_t)(uintptr_t)invoke_test_wait, (uint32_t)(uintptr_t)ctx };
+    hotreload_invoke_result_t res;
+    ctx->err = hotreload_invoke(symbol_index("reloadable_call"), args, 2, 1, &res);
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void reload_test_task(void *arg)
+{
+    invoke_reload_ctx_t *ctx = (invoke_reload_ctx_t *)arg;
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    ctx->err = hotreload_reload(&config);
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("invoke holds off a reload until the calls return", "[hotreload][invoke]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_wait_published(1000));
+
+    invoke_reload_ctx_t invoke = {
+        .entered = xSemaphoreCreateBinary(),
+        .release = xSemaphoreCreateBinary(),
+        .done = xSemaphoreCreateBinary(),
+        .err = ESP_FAIL,
+    };
+    invoke_reload_ctx_t reload = {
+        .done = xSemaphoreCreateBinary(),
+        .err = ESP_FAIL,
+    };
+    TEST_ASSERT_NOT_NULL(invoke.entered);
+    TEST_ASSERT_NOT_NULL(invoke.release);
+    TEST_ASSERT_NOT_NULL(invoke.done);
+    TEST_ASSERT_NOT_NULL(reload.done);
+
+    hotreload_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+
+    // The invoked function blocks inside the module until released
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(invoke_test_task, "invoke_test", 4096, &invoke, 5, NULL));
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(invoke.entered, pdMS_TO_TICKS(1000)));
+
+    // The reload must not publish or free anything while the call runs
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(reload_test_task, "reload_test", 4096, &reload, 5, NULL));
+    TEST_ASSERT_EQUAL(pdFALSE, xSemaphoreTake(reload.done, pdMS_TO_TICKS(100)));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.load_count, after.load_count);
+
+    xSemaphoreGive(invoke.release);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(invoke.done, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(ESP_OK, invoke.err);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(reload.done, pdMS_TO_TICKS(5000)));
+    TEST_ASSERT_EQUAL(ESP_OK, reload.err);
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.load_count + 1, after.load_count);
+    TEST_ASSERT_EQUAL(42, reloadable_get_compile_def_value());
+
+    vSemaphoreDelete(invoke.entered);
+    vSemaphoreDelete(invoke.release);
+    vSemaphoreDelete(invoke.done);
+    vSemaphoreDelete(reload.done);
+    hotreload_unload();
+}
+
+// ============================================================================
+// Stack tracking tests - CONFIG_HOTRELOAD_STACK_TRACKING
+// ============================================================================
+
+#if CONFIG_HOTRELOAD_STACK_TRACKING
+
+static size_t stack_usage_index(const char *func_name)
+{
+    hotreload_stack_usage_t usage;
+    const char *name;
+    for (size_t i = 0; hotreload_get_stack_usage(i, &name, &usage) == ESP_OK; i++) {
+        if (strcmp(name, func_name) == 0) {
+            return i;
+        }
+    }
+    TEST_FAIL_MESSAGE("function not found in stack usage table");
+    return 0;
+}
+
+TEST_CASE("stack tracking records calls into the module", "[hotreload][stack]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    size_t idx = stack_usage_index("reloadable_hello");
+    hotreload_stack_usage_t usage;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stack_usage(idx, NULL, &usage));
+    TEST_ASSERT_EQUAL(0, usage.calls);
+    TEST_ASSERT_EQUAL(0, usage.max_depth);
+
+    reloadable_hello("Stack");
+    reloadable_hello("Stack");
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stack_usage(idx, NULL, &usage));
+    TEST_ASSERT_EQUAL(2, usage.calls);
+    TEST_ASSERT_FALSE(usage.overflowed);
+    // printf() alone needs several hundred bytes of stack
+    TEST_ASSERT_GREATER_THAN(256, usage.max_depth);
+    TEST_ASSERT_LESS_THAN(CONFIG_HOTRELOAD_STACK_TRACKING_WINDOW, usage.max_depth);
+    printf("reloadable_hello: %" PRIu32 " bytes of stack\n", usage.max_depth);
+
+    hotreload_unload();
+}
+
+TEST_CASE("stack tracking figures are reset on reload", "[hotreload][stack]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    size_t idx = stack_usage_index("reloadable_hello");
+    reloadable_hello("Before reload");
+
+    hotreload_stack_usage_t usage;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stack_usage(idx, NULL, &usage));
+    TEST_ASSERT_EQUAL(1, usage.calls);
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload(&config));
+
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stack_usage(idx, NULL, &usage));
+    TEST_ASSERT_EQUAL(0, usage.calls);
+    TEST_ASSERT_EQUAL(0, usage.max_depth);
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_get_stack_usage validates arguments", "[hotreload][stack]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_stack_usage_t usage;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_get_stack_usage(0, NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, hotreload_get_stack_usage(SIZE_MAX, NULL, &usage));
+
+    hotreload_unload();
+}
+
+#endif // CONFIG_HOTRELOAD_STACK_TRACKING
+
+// ============================================================================
+// Stack-scan commit tests - hotreload_reload_when_safe()
+// ============================================================================
+
+typedef struct {
+    SemaphoreHandle_t release;
+    SemaphoreHandle_t done;
+} safe_test_ctx_t;
+
+// Called from inside the module, blocks until the test releases it
+static void safe_test_wait(void *arg)
+{
+    safe_test_ctx_t *ctx = (safe_test_ctx_t *)arg;
+    xSemaphoreTake(ctx->release, portMAX_DELAY);
+}
+
+static void safe_test_task(void *arg)
+{
+    safe_test_ctx_t *ctx = (safe_test_ctx_t *)arg;
+    reloadable_call(safe_test_wait, ctx);
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("hotreload_reload_when_safe commits when no task is in the module", "[hotreload][safe]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    hotreload_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_when_safe(&config, 100));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.load_count + 1, after.load_count);
+
+    reloadable_init();
+    reloadable_hello("Safe");
+
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_when_safe waits for a task blocked in the module", "[hotreload][safe]")
+{
+    hotreload_config_t config = HOTRELOAD_CONFIG_DEFAULT();
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_load(&config));
+
+    safe_test_ctx_t ctx = {
+        .release = xSemaphoreCreateBinary(),
+        .done = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_NULL(ctx.release);
+    TEST_ASSERT_NOT_NULL(ctx.done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(safe_test_task, "safe_test", 4096, &ctx, 5, NULL));
+    vTaskDelay(pdMS_TO_TICKS(20));
+
+    hotreload_stats_t before, after;
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&before));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, hotreload_reload_when_safe(&config, 50));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_get_stats(&after));
+    TEST_ASSERT_EQUAL(before.load_count, after.load_count);
+    TEST_ASSERT_FALSE(hotreload_reload_in_progress());
+
+    // Old code is still live and usable
+    reloadable_hello("Still old");
+
+    // Once the task has left the module, the reload goes through
+    xSemaphoreGive(ctx.release);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx.done, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(ESP_OK, hotreload_reload_when_safe(&config, 100));
+
+    vSemaphoreDelete(ctx.release);
+    vSemaphoreDelete(ctx.done);
+    hotreload_unload();
+}
+
+TEST_CASE("hotreload_reload_when_safe rejects invalid arguments", "[hotreload][safe]")
+{
+    hotreload_config_t config = { .partition_label = NULL };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_reload_when_safe(NULL, 100));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, hotreload_reload_when_safe(&config, 100));
+}
+
 // ============================================================================
 // PSRAM (SPIRAM) loading tests - ESP32-S2, ESP32-S3 only
 // ============================================================================
@@ -7,6 +7,8 @@ This file contains:
 2. E2E integration test - tests full hot reload workflow
 3. idf.py reload command test - tests the CLI workflow
 4. idf.py watch + qemu combined test - tests background watcher with QEMU
+5. idf.py reload-daemon test - tests idf.py reload through the warm daemon
+6. Loader benchmark - exact per-phase instruction counts in QEMU with -icount (opt-in)
 
 == QEMU Tests ==
 Run unit tests (QEMU):
@@ -15,6 +17,10 @@ Run unit tests (QEMU):
 Run e2e test (QEMU):
     pytest test_hotreload.py::test_hot_reload_e2e -v -s --embedded-services idf,qemu
 
+Run loader benchmark (QEMU), optionally comparing against a stored baseline:
+    pytest test_hotreload.py::test_loader_phase_instructions -v -s --embedded-services idf,qemu \\
+        --loader-benchmark [--loader-baseline loader_baseline.json] [--loader-save-baseline loader_baseline.json]
+
 == Hardware Tests ==
 Run unit tests (hardware):
     pytest test_hotreload.py::test_hotreload_unit_tests_hardware -v -s \\
@@ -25,6 +31,7 @@ Supported targets are defined in idf_component.yml at the project root.
 
 import hashlib
 import hmac as hmac_module
+import json
 import os
 import socket
 import subprocess
@@ -271,6 +278,126 @@ def test_hotreload_unit_tests(dut):
     print("\n=== Unit Tests Complete ===\n")
 
 
+# With shift=5 every guest instruction advances the virtual clock by exactly
+# 32 ns, and the CPU cycle counter follows the virtual clock. align=off and
+# sleep=off decouple the virtual clock from host time.
+#
+# The counter then advances by freq_mhz * 32 / 1000 per instruction (5.12 at
+# 160 MHz). The error of a counter difference is below one count, so as long
+# as an instruction is worth at least two counts, dividing by that rate and
+# rounding gives the exact number of instructions.
+ICOUNT_SHIFT = 5
+ICOUNT_QEMU_ARGS = f"-icount shift={ICOUNT_SHIFT},align=off,sleep=off"
+
+
+def cycles_per_instruction(cal_0: int, cal_1000: int) -> float:
+    """Counter rate per instruction, from the Unity case's calibration block.
+
+    The measured rate is snapped to the rate of a whole-MHz clock, which makes
+    the conversion exact instead of carrying the calibration error along.
+    """
+    measured = (cal_1000 - cal_0) / 1000.0
+    ns_per_insn = 1 << ICOUNT_SHIFT
+    freq_mhz = round(measured * 1000 / ns_per_insn)
+    rate = freq_mhz * ns_per_insn / 1000.0
+    assert abs(rate - measured) < 0.01, \
+        f"cycle counter does not follow the virtual clock ({measured:.3f} counts per instruction)"
+    assert rate >= 2, \
+        f"{rate:.2f} counts per instruction at {freq_mhz} MHz is too coarse, raise ICOUNT_SHIFT"
+    return rate
+
+
+def compare_loader_baseline(target: str, insns: dict, baseline_path: Path, tolerance_pct: float) -> list[str]:
+    """Compare per-phase instruction counts against a stored baseline.
+
+    Returns a list of regression descriptions (empty if none).
+    """
+    baseline = json.loads(baseline_path.read_text()).get(target, {}).get("instructions")
+    if baseline is None:
+        print(f"  No baseline for {target} in {baseline_path}, skipping comparison")
+        return []
+
+    regressions = []
+    print(f"  {'phase':<12} {'baseline':>12} {'current':>12} {'delta':>8}")
+    for phase, count in insns.items():
+        base = baseline.get(phase)
+        if base is None:
+            print(f"  {phase:<12} {'-':>12} {count:>12}")
+            continue
+        delta_pct = (count - base) * 100.0 / base if base else 0.0
+        print(f"  {phase:<12} {base:>12} {count:>12} {delta_pct:>+7.2f}%")
+        if count > base * (1 + tolerance_pct / 100.0):
+            regressions.append(f"{phase}: {base} -> {count} ({delta_pct:+.2f}%)")
+    return regressions
+
+
+def save_loader_baseline(target: str, insns: dict, baseline_path: Path) -> None:
+    """Store per-phase instruction counts for a target, keeping other targets' entries."""
+    baseline = json.loads(baseline_path.read_text()) if baseline_path.exists() else {}
+    baseline[target] = {"instructions": insns}
+    baseline_path.write_text(json.dumps(baseline, indent=2, sort_keys=True) + "\n")
+    print(f"  Baseline for {target} saved to {baseline_path}")
+
+
+@pytest.mark.host_test
+@pytest.mark.qemu
+@pytest.mark.parametrize("target", QEMU_TARGETS, indirect=True)
+@pytest.mark.parametrize("embedded_services", ["idf,qemu"], indirect=True)
+@pytest.mark.parametrize("qemu_extra_args", [ICOUNT_QEMU_ARGS], indirect=True)
+def test_loader_phase_instructions(dut, target, request):
+    """
+    Report exact per-phase instruction counts of the loader in QEMU.
+
+    Runs the "loader phase instruction counts" Unity case, which loads the
+    module several times and prints the fastest cycle count of each load
+    phase, plus the cycles taken by a block of 1000 instructions. QEMU runs
+    with -icount, so the cycle counter moves by a fixed amount per
+    instruction, and the counts convert exactly (see ICOUNT_QEMU_ARGS).
+
+    Only runs with --loader-benchmark. With --loader-baseline, fails if a
+    phase executes more instructions than the baseline by more than
+    --loader-tolerance percent. With --loader-save-baseline, stores the
+    counts for this target.
+    """
+    config = request.config
+    if not config.getoption("loader_benchmark"):
+        pytest.skip("loader benchmark not requested (use --loader-benchmark)")
+
+    print(f"\n=== Loader Benchmark ({target}, {ICOUNT_QEMU_ARGS}) ===\n")
+
+    dut.expect_exact("Press ENTER to see the list of tests.", timeout=60)
+    dut.write('"loader phase instruction counts"')
+
+    match = dut.expect(re.compile(rb"LOADER_CALIBRATION (\d+) (\d+)"), timeout=120)
+    rate = cycles_per_instruction(int(match.group(1)), int(match.group(2)))
+
+    insns = {}
+    while True:
+        match = dut.expect(re.compile(rb"LOADER_(?:PHASE_CYCLES (\w+) (\d+)|DONE)"), timeout=120)
+        if match.group(1) is None:
+            break
+        insns[match.group(1).decode()] = round(int(match.group(2)) / rate)
+
+    print(f"  {rate:.2f} cycles per instruction")
+    for phase, count in insns.items():
+        print(f"  {phase:<12} {count:>12}")
+    print(f"  {'total':<12} {sum(insns.values()):>12}")
+
+    regressions = []
+    baseline = config.getoption("loader_baseline")
+    if baseline:
+        regressions = compare_loader_baseline(target, insns, Path(baseline),
+                                              config.getoption("loader_tolerance"))
+
+    save_path = config.getoption("loader_save_baseline")
+    if save_path:
+        save_loader_baseline(target, insns, Path(save_path))
+
+    assert not regressions, "Loader phases slower than baseline:\n  " + "\n  ".join(regressions)
+
+    print("\n=== Loader Benchmark Complete ===\n")
+
+
 @pytest.mark.host_test
 @pytest.mark.qemu
 @pytest.mark.parametrize("target", QEMU_NETWORK_TARGETS, indirect=True)
@@ -345,6 +472,21 @@ def test_hot_reload_e2e(dut, app, original_code, qemu_host_port):
 
     # Step 6: Upload ELF (app will reload via cooperative polling)
     print("Step 6: Uploading new ELF...")
+    # Digests are computed while the body is received; the partition is only
+    # written once both match
+    elf_data = get_reloadable_elf_path(build_dir).read_bytes()
+    headers = {"Content-Type": "application/octet-stream"}
+    _add_hmac_headers(headers, elf_data, build_dir)
+    corrupted = b"\0" + elf_data[1:]  # Body no longer matches X-Hotreload-SHA256
+    forged = dict(headers, **{"X-Hotreload-HMAC": "00" * 32})
+    for body, bad_headers, expected in ((corrupted, headers, "SHA-256"), (elf_data, forged, "HMAC")):
+        response = requests.post(f"http://127.0.0.1:{host_port}/upload",
+                                 data=body, headers=bad_headers, timeout=30)
+        assert response.status_code == 403, f"Tampered upload accepted: {response.text}"
+        assert expected in response.text, f"Unexpected rejection: {response.text}"
+    response = requests.get(f"http://127.0.0.1:{host_port}/pending", timeout=5)
+    assert response.json()["pending"] is False, "Rejected upload marked an update as pending"
+
     response = upload_elf(host_port, build_dir)
     print(f"  Server response: {response.status_code} - {response.text.strip()}")
     assert response.status_code == 200, f"Upload failed: {response.text}"
@@ -360,6 +502,38 @@ def test_hot_reload_e2e(dut, app, original_code, qemu_host_port):
     dut.expect(r"Goodbye.*from main loop", timeout=15)
     print("  Main loop still running with new code - no crash!")
 
+    # Step 8: The benchmark gate compared old and new code before committing
+    # (esp32-qemu-benchmark-gate preset only)
+    if app.sdkconfig.get("HOTRELOAD_BENCHMARK_GATE"):
+        print("Step 8: Checking benchmark result...")
+        response = requests.get(f"http://127.0.0.1:{host_port}/benchmark", timeout=5)
+        assert response.status_code == 200, f"GET /benchmark failed: {response.text}"
+        result = response.json()
+        print(f"  Benchmark: {result}")
+        assert result["verdict"] == "kept", f"Unexpected benchmark verdict: {result}"
+        assert result["old_cycles"] > 0 and result["new_cycles"] > 0
+    else:
+        print("Step 8: Benchmark gate disabled, skipping")
+
+    # Step 9: Call a module function from the host and time it
+    print("Step 9: Invoking reloadable_get_compile_def_value...")
+    body = b"name=reloadable_get_compile_def_value&repeat=20"
+    headers = {"Content-Type": "application/x-www-form-urlencoded"}
+    _add_hmac_headers(headers, body, build_dir)
+    response = requests.post(f"http://127.0.0.1:{host_port}/invoke", data=body, headers=headers, timeout=10)
+    assert response.status_code == 200, f"POST /invoke failed: {response.text}"
+    result = response.json()
+    print(f"  Invoke: {result}")
+    assert result["result"] == 42
+    assert result["calls"] == 20
+    assert 0 < result["min_cycles"] <= result["mean_cycles"] <= result["max_cycles"]
+
+    for bad in (b"index=abc", b"index=0x1", b"name=reloadable_get_compile_def_value&repeat=5x"):
+        headers = {"Content-Type": "application/x-www-form-urlencoded"}
+        _add_hmac_headers(headers, bad, build_dir)
+        response = requests.post(f"http://127.0.0.1:{host_port}/invoke", data=bad, headers=headers, timeout=10)
+        assert response.status_code == 400, f"Malformed invoke {bad!r} accepted: {response.text}"
+
     print("\n=== Hot Reload E2E Test PASSED ===\n")
 
 
@@ -671,6 +845,98 @@ def test_idf_watch_with_qemu(target, original_code):
         print("  Process terminated.")
 
 
+@pytest.mark.host_test
+@pytest.mark.qemu
+@pytest.mark.parametrize("target", QEMU_NETWORK_TARGETS, indirect=True)
+@pytest.mark.parametrize("embedded_services", ["idf,qemu"], indirect=True)
+@pytest.mark.parametrize(
+    "qemu_extra_args",
+    [f"-nic user,model=open_eth,id=lo0,hostfwd=tcp:127.0.0.1:{{host_port}}-:{DEVICE_PORT}"],
+    indirect=True,
+)
+def test_idf_reload_daemon(dut, app, original_code, qemu_host_port):
+    """
+    Test idf.py reload going through a running idf.py reload-daemon.
+
+    Steps:
+    1. Start device with hotreload server
+    2. Start `idf.py reload-daemon --url <device-url>` for the same build directory
+    3. Modify reloadable source code
+    4. Run `idf.py reload` without --url; the daemon builds and uploads
+    5. Verify the reload succeeded
+    """
+    print("\n=== Testing idf.py reload-daemon ===\n")
+
+    host_port = qemu_host_port
+    build_dir = Path(app.binary_path)
+    url = f"http://127.0.0.1:{host_port}"
+
+    # Step 1: Select the integration test and wait for the server
+    print("Step 1: Starting integration test on the device...")
+    dut.expect_exact("Press ENTER to see the list of tests.", timeout=60)
+    dut.write('"hotreload_integration"')
+    dut.expect(r"Hello.*from initial load", timeout=120)
+    dut.expect(rf"Hotreload server started (at http://[\d.]+:{DEVICE_PORT}|on port {DEVICE_PORT})", timeout=30)
+    time.sleep(3)
+    for i in range(15):
+        if check_server_status(host_port):
+            break
+        time.sleep(1)
+    else:
+        pytest.fail("Server not accessible after 15 attempts")
+    print("  Server started!")
+
+    # Step 2: Start the daemon
+    print(f"Step 2: Starting 'idf.py -B {build_dir} reload-daemon --url {url}'...")
+    process = subprocess.Popen(
+        ["idf.py", "-B", str(build_dir), "reload-daemon", "--url", url],
+        cwd=PROJECT_DIR,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True,
+        bufsize=1,
+        start_new_session=True,
+    )
+    capture = OutputCapture(process)
+    capture.start()
+
+    try:
+        assert capture.wait_for_stderr(r"\[hotreload\] Reload daemon listening", timeout=60), \
+            "Daemon should start"
+        assert (build_dir / "hotreload_daemon.json").exists()
+        print("  Daemon running!")
+
+        # Step 3: Modify reloadable code
+        print("Step 3: Modifying reloadable code (Hello -> Hiya)...")
+        modify_reloadable_code("Hiya")
+
+        # Step 4: idf.py reload picks up the URL and the work from the daemon
+        print("Step 4: Running 'idf.py reload'...")
+        cmd = ["idf.py", "-B", str(build_dir), "reload"]
+        result = subprocess.run(cmd, cwd=PROJECT_DIR, capture_output=True, text=True, timeout=180)
+        print(f"  stdout:\n{result.stdout}")
+        assert result.returncode == 0, f"idf.py reload failed: {result.stderr}"
+        assert "Upload complete!" in result.stdout
+        assert "building here" not in result.stdout, "Reload should have gone through the daemon"
+
+        # Step 5: Verify reload on device
+        print("Step 5: Waiting for app to reload...")
+        dut.expect("Reload successful", timeout=30)
+        dut.expect(r"Hiya.*from main loop", timeout=15)
+        print("\n=== idf.py reload-daemon Test PASSED ===\n")
+
+    finally:
+        capture.stop()
+        try:
+            os.killpg(os.getpgid(process.pid), signal.SIGINT)
+            process.wait(timeout=10)
+        except (ProcessLookupError, PermissionError):
+            pass
+        except subprocess.TimeoutExpired:
+            os.killpg(os.getpgid(process.pid), signal.SIGKILL)
+            process.wait()
+
+
 # =============================================================================
 # Hardware Tests (Real ESP32 hardware, no QEMU)
 # =============================================================================
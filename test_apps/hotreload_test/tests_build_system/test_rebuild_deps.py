@@ -283,6 +283,127 @@ def test_main_elf_not_rebuilt_on_reloadable_change():
     print("\n=== Test PASSED: Main ELF correctly not rebuilt on reloadable-only change ===\n")
 
 
+def test_noop_build_runs_no_scripts():
+    """
+    Test that building an unchanged tree does not run any hotreload script.
+
+    Stub, linker script and digest generation are custom commands with real
+    outputs and inputs, so a second build with nothing changed must neither
+    invoke them nor touch the generated files.
+
+    Steps:
+    1. Build the project (or use existing build) and warm up
+    2. Record timestamps of the generated files
+    3. Run a verbose build without changing anything
+    4. Verify no hotreload script was invoked and no file was rewritten
+    """
+    print("\n=== Testing No-op Build ===\n")
+
+    # Step 1: Ensure build exists
+    print("Step 1: Ensuring build exists...")
+    build_dir = find_build_dir()
+    if not build_dir.exists():
+        result = run_idf_command(["build"], build_dir=build_dir)
+        if result.returncode != 0:
+            raise AssertionError("Initial build failed")
+        build_dir = find_build_dir()
+
+    print(f"  Build directory: {build_dir}")
+    print("  Running warm-up build to stabilize CMake state...")
+    warm_up_build(build_dir)
+
+    # Step 2: Record timestamps
+    print("Step 2: Recording timestamps...")
+    main_elf, reloadable_so, ld_script = get_build_paths(build_dir)
+    reloadable_build_dir = build_dir / "esp-idf" / "reloadable"
+    generated = [
+        main_elf,
+        reloadable_so,
+        ld_script,
+        reloadable_build_dir / "reloadable_stubs.S",
+        reloadable_build_dir / "reloadable_symbol_table.c",
+    ]
+    mtimes_before = {path: path.stat().st_mtime for path in generated}
+
+    # Step 3: No-op build, verbose so that every command run is printed
+    print("Step 3: No-op build...")
+    time.sleep(1.1)  # Ensure filesystem timestamp resolution is exceeded
+    result = run_idf_command(["-v", "build"], build_dir=build_dir)
+    if result.returncode != 0:
+        print(f"Build stdout:\n{result.stdout}")
+        print(f"Build stderr:\n{result.stderr}")
+        raise AssertionError("No-op build failed")
+
+    # Step 4: Verify nothing was regenerated
+    print("Step 4: Verifying nothing ran...")
+    for script in ["gen_exports.py", "gen_reloadable.py", "gen_ld_script.py", "gen_readonly_digest.py"]:
+        assert script not in result.stdout, f"{script} should not run in a no-op build"
+    print("  [PASS] No hotreload script was invoked")
+
+    for path, mtime in mtimes_before.items():
+        assert path.stat().st_mtime == mtime, f"{path.name} should not be rewritten in a no-op build"
+    print("  [PASS] Generated files were not rewritten")
+
+    print("\n=== Test PASSED: No-op build does no hotreload work ===\n")
+
+
+def test_export_list_from_headers():
+    """
+    Test that the export list is taken from EXPORT_HEADERS and EXPORTS.
+
+    The reloadable test component exports the functions declared in
+    include/reloadable.h plus hotreload_benchmark. reloadable.c also defines
+    a global helper that is not declared in the header; it must not get a
+    stub or a symbol table slot. The prototypes from the header, and only
+    those, are recorded in the signature manifest for hotreload_invoke().
+    """
+    print("\n=== Testing Export List Generation ===\n")
+
+    build_dir = find_build_dir()
+    if not build_dir.exists():
+        result = run_idf_command(["build"], build_dir=build_dir)
+        if result.returncode != 0:
+            raise AssertionError("Initial build failed")
+        build_dir = find_build_dir()
+
+    reloadable_build_dir = build_dir / "esp-idf" / "reloadable"
+    exports = (reloadable_build_dir / "reloadable_exports.txt").read_text().split()
+    print(f"  Exports: {exports}")
+
+    assert exports == [
+        "reloadable_init",
+        "reloadable_hello",
+        "reloadable_isr",
+        "reloadable_get_compile_def_value",
+        "reloadable_call",
+        "hotreload_benchmark",
+    ], "Export list should contain the header prototypes followed by EXPORTS"
+    print("  [PASS] Export list matches header and EXPORTS")
+
+    signatures = (reloadable_build_dir / "reloadable_signatures.txt").read_text().splitlines()
+    print(f"  Signatures: {signatures}")
+    assert signatures == [
+        "reloadable_init void 0",
+        "reloadable_hello void 1",
+        "reloadable_isr void 1",
+        "reloadable_get_compile_def_value int 0",
+        "reloadable_call void 2",
+    ], "Signature manifest should list the header prototypes only"
+    print("  [PASS] Signature manifest matches header prototypes")
+
+    symbol_table = (reloadable_build_dir / "reloadable_symbol_table.c").read_text()
+    assert '"reloadable_next_count"' not in symbol_table, \
+        "Unexported helper should not be in the symbol table"
+    stubs = (reloadable_build_dir / "reloadable_stubs.S").read_text()
+    assert "reloadable_next_count:" not in stubs, \
+        "Unexported helper should not get a stub"
+    print("  [PASS] Unexported helper has no stub")
+
+    print("\n=== Test PASSED: Export list generated from headers ===\n")
+
+
 if __name__ == "__main__":
     test_reloadable_rebuild_on_linker_script_change()
     test_main_elf_not_rebuilt_on_reloadable_change()
+    test_noop_build_runs_no_scripts()
+    test_export_list_from_headers()